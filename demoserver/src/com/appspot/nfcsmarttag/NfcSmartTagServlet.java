@@ -20,6 +20,7 @@
 package com.appspot.nfcsmarttag;
 
 import com.appspot.nfcsmarttag.url.InvalidInputException;
+import com.appspot.nfcsmarttag.url.LatencyAggregator;
 import com.appspot.nfcsmarttag.url.SimpleKeyStore;
 import com.appspot.nfcsmarttag.url.SmartTagKeyStoreInterface;
 import com.appspot.nfcsmarttag.url.Url4Tag;
@@ -41,6 +42,9 @@ public class NfcSmartTagServlet extends HttpServlet {
   private static final String PAGE_FOOTER = "</body></html>";
   
   SmartTagKeyStoreInterface keyStore;
+
+  // Latency of all stations seen by this instance
+  private static final LatencyAggregator latencyAggregator = new LatencyAggregator();
   
   public NfcSmartTagServlet() {
     keyStore = new SimpleKeyStore();  
@@ -67,6 +71,11 @@ public class NfcSmartTagServlet extends HttpServlet {
         resp.getWriter().println("<pre>");
         resp.getWriter().println("Tag Id:" + hexString(url4tag.getTagId()));
         resp.getWriter().println("SmartTagInfo:\n" + url4tag.getNfcSmartTagInfo());
+        if (url4tag.getLatencyHistogram() != null) {
+          latencyAggregator.add(url4tag);
+          resp.getWriter().println("Latency histogram:\n" + url4tag.getLatencyHistogram());
+          resp.getWriter().println("All stations:\n" + latencyAggregator);
+        }
         resp.getWriter().println("</pre>");
       } catch (InvalidInputException e) {
         resp.getWriter().println("Decoding error");          
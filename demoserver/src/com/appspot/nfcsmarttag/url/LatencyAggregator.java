@@ -0,0 +1,126 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Fleet-wide latency histograms from the URLs of all base stations.
+ */
+
+package com.appspot.nfcsmarttag.url;
+
+import java.util.Arrays;
+import java.util.LinkedHashMap;
+import java.util.Map;
+
+/**
+ * Sums the latency histograms of decoded URLs over all stations. Stations
+ * send counts since their last reset, so each URL adds the difference to
+ * the last URL of its station with the same kind of histogram. Kept in
+ * memory only, per instance. Only the last reports of the
+ * {@link #MAX_REPORTS} most recently seen stations and kinds are kept; a
+ * station seen again after being dropped adds its counts since reset.
+ */
+public class LatencyAggregator {
+  /** Maximum number of last reports kept, one per station and kind. */
+  public static final int MAX_REPORTS = 1000;
+
+  /** Last report of a station for one kind of histogram. */
+  private static class Report {
+    final long counter;
+    final long resets;
+    final LatencyHistogram histogram;
+
+    Report(long counter, long resets, LatencyHistogram histogram) {
+      this.counter = counter;
+      this.resets = resets;
+      this.histogram = histogram;
+    }
+  }
+
+  @SuppressWarnings("serial")
+  private final Map<String, Report> lastReports =
+      new LinkedHashMap<String, Report>(16, 0.75f, true) {
+        @Override
+        protected boolean removeEldestEntry(Map.Entry<String, Report> eldest) {
+          return size() > MAX_REPORTS;
+        }
+      };
+  private final long[][] totals =
+      new long[LatencyHistogram.Kind.values().length][LatencyHistogram.BUCKETS];
+
+  /**
+   * Returns the number of resets of a station. The histograms start over
+   * whenever it changes.
+   */
+  private static long resetCount(NfcSmartTag.NfcSmartTagInfo info) {
+    return (long) info.getNumberPowerReset() + info.getNumberExternalReset()
+        + info.getNumberBrownOut() + info.getNumberWatchdog();
+  }
+
+  /**
+   * Adds the touches counted since the last URL of the same station and
+   * kind of histogram. URLs that are not newer than that one, such as a
+   * URL pushed again to the same phone, add nothing.
+   *
+   * @param url a decoded URL.
+   * @return true if the URL carried a histogram that was added.
+   */
+  public synchronized boolean add(Url4Tag url) {
+    LatencyHistogram histogram = url.getLatencyHistogram();
+    if (histogram == null) {
+      return false;
+    }
+    LatencyHistogram.Kind kind = histogram.getKind();
+    String key = Arrays.toString(url.getTagId()) + kind;
+    long resets = resetCount(url.getNfcSmartTagInfo());
+
+    Report last = lastReports.get(key);
+    if (last != null && url.getCounter() <= last.counter) {
+      return false;
+    }
+    for (int i = 0; i < LatencyHistogram.BUCKETS; i++) {
+      int count = histogram.getCount(i);
+      if (last != null && last.resets == resets) {
+        // Counts wrap at 256
+        count = (count - last.histogram.getCount(i)) & 0xff;
+      }
+      totals[kind.ordinal()][i] += count;
+    }
+    lastReports.put(key, new Report(url.getCounter(), resets, histogram));
+    return true;
+  }
+
+  /**
+   * Returns the touches per bucket of a kind of histogram over all
+   * stations, see {@link LatencyHistogram#bucketLimitMs(int)}.
+   *
+   * @param kind the kind of histogram.
+   * @return a copy of the counts.
+   */
+  public synchronized long[] getTotals(LatencyHistogram.Kind kind) {
+    return totals[kind.ordinal()].clone();
+  }
+
+  @Override
+  public synchronized String toString() {
+    StringBuilder stringBuilder = new StringBuilder();
+    for (LatencyHistogram.Kind kind : LatencyHistogram.Kind.values()) {
+      stringBuilder.append(kind).append(":");
+      for (long count : totals[kind.ordinal()]) {
+        stringBuilder.append(" ").append(count);
+      }
+      stringBuilder.append("\n");
+    }
+    return stringBuilder.toString();
+  }
+}
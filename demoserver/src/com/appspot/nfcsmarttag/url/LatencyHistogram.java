@@ -0,0 +1,130 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Latency histogram sent by a base station in the NFC Url.
+ */
+
+package com.appspot.nfcsmarttag.url;
+
+import com.google.protobuf.ByteString;
+import com.google.protobuf.InvalidProtocolBufferException;
+
+/**
+ * A latency histogram from the NfcBaseStationInfo payload. A URL carries
+ * at most one of the kinds, in turn by counter.
+ *
+ * Bucket b counts times below {@link #FIRST_BUCKET_MS} &lt;&lt; b, the last
+ * bucket all longer times. Counts start at 0 when the station resets and
+ * wrap at 256, so only differences between reports of a station count
+ * touches. See {@link LatencyAggregator}.
+ */
+public class LatencyHistogram {
+  public static final int BUCKETS = 8;
+  public static final int FIRST_BUCKET_MS = 16;
+
+  /** Kinds of histograms with their NfcBaseStationInfo field numbers. */
+  public enum Kind {
+    /** Phone seen until the URL is delivered. */
+    TOUCH_TO_PUSH(NfcSmartTag.NfcSmartTagInfo.TOUCH_TO_PUSH_MS_FIELD_NUMBER),
+    /** Felica poll started until a phone answered. */
+    POLL_TO_DETECT(NfcSmartTag.NfcSmartTagInfo.POLL_TO_DETECT_MS_FIELD_NUMBER),
+    /** LLCP exchange of a completed SNEP/NPP push. */
+    LLCP_SESSION(NfcSmartTag.NfcSmartTagInfo.LLCP_SESSION_MS_FIELD_NUMBER);
+
+    private final int fieldNumber;
+
+    private Kind(int fieldNumber) {
+      this.fieldNumber = fieldNumber;
+    }
+
+    public int getFieldNumber() {
+      return fieldNumber;
+    }
+  }
+
+  private final Kind kind;
+  private final int[] counts;
+
+  protected LatencyHistogram(Kind kind, int[] counts) {
+    this.kind = kind;
+    this.counts = counts;
+  }
+
+  /**
+   * Finds the histogram in a decoded NfcSmartTagInfo.
+   *
+   * @param info station info from a URL.
+   * @return the histogram, or null if the info has none.
+   * @throws InvalidProtocolBufferException if the histogram is broken.
+   */
+  public static LatencyHistogram fromInfo(NfcSmartTag.NfcSmartTagInfo info)
+      throws InvalidProtocolBufferException {
+    if (info.hasTouchToPushMs()) {
+      return fromBytes(Kind.TOUCH_TO_PUSH, info.getTouchToPushMs());
+    } else if (info.hasPollToDetectMs()) {
+      return fromBytes(Kind.POLL_TO_DETECT, info.getPollToDetectMs());
+    } else if (info.hasLlcpSessionMs()) {
+      return fromBytes(Kind.LLCP_SESSION, info.getLlcpSessionMs());
+    }
+    return null;
+  }
+
+  private static LatencyHistogram fromBytes(Kind kind, ByteString bytes)
+      throws InvalidProtocolBufferException {
+    if (bytes.size() > BUCKETS) {
+      throw new InvalidProtocolBufferException("Too many buckets in " + kind);
+    }
+    // Trailing zero buckets are left out
+    int[] counts = new int[BUCKETS];
+    for (int i = 0; i < bytes.size(); i++) {
+      counts[i] = bytes.byteAt(i) & 0xff;
+    }
+    return new LatencyHistogram(kind, counts);
+  }
+
+  /**
+   * Returns the upper bound of a bucket.
+   *
+   * @param bucket index of the bucket.
+   * @return times in the bucket are below this many ms, or
+   *         Integer.MAX_VALUE for the last bucket.
+   */
+  public static int bucketLimitMs(int bucket) {
+    return bucket < BUCKETS - 1 ? FIRST_BUCKET_MS << bucket : Integer.MAX_VALUE;
+  }
+
+  public Kind getKind() {
+    return kind;
+  }
+
+  /**
+   * Returns the count of a bucket, 0 to 255.
+   *
+   * @param bucket index of the bucket.
+   * @return the count.
+   */
+  public int getCount(int bucket) {
+    return counts[bucket];
+  }
+
+  @Override
+  public String toString() {
+    StringBuilder stringBuilder = new StringBuilder(kind.toString());
+    for (int i = 0; i < BUCKETS; i++) {
+      stringBuilder.append(i == 0 ? ": " : " ").append(counts[i]);
+    }
+    return stringBuilder.toString();
+  }
+}
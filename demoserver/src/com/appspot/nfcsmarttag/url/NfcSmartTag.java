@@ -34,6 +34,26 @@ public final class NfcSmartTag {
     // optional uint32 battery_voltage = 6;
     boolean hasBatteryVoltage();
     int getBatteryVoltage();
+    
+    // optional uint32 poll_interval_ms = 7;
+    boolean hasPollIntervalMs();
+    int getPollIntervalMs();
+    
+    // optional uint32 target_mode_retry = 8;
+    boolean hasTargetModeRetry();
+    int getTargetModeRetry();
+    
+    // optional bytes touch_to_push_ms = 9;
+    boolean hasTouchToPushMs();
+    com.google.protobuf.ByteString getTouchToPushMs();
+    
+    // optional bytes poll_to_detect_ms = 10;
+    boolean hasPollToDetectMs();
+    com.google.protobuf.ByteString getPollToDetectMs();
+    
+    // optional bytes llcp_session_ms = 11;
+    boolean hasLlcpSessionMs();
+    com.google.protobuf.ByteString getLlcpSessionMs();
   }
   public static final class NfcSmartTagInfo extends
       com.google.protobuf.GeneratedMessage
@@ -124,6 +144,56 @@ public final class NfcSmartTag {
       return batteryVoltage_;
     }
     
+    // optional uint32 poll_interval_ms = 7;
+    public static final int POLL_INTERVAL_MS_FIELD_NUMBER = 7;
+    private int pollIntervalMs_;
+    public boolean hasPollIntervalMs() {
+      return ((bitField0_ & 0x00000040) == 0x00000040);
+    }
+    public int getPollIntervalMs() {
+      return pollIntervalMs_;
+    }
+    
+    // optional uint32 target_mode_retry = 8;
+    public static final int TARGET_MODE_RETRY_FIELD_NUMBER = 8;
+    private int targetModeRetry_;
+    public boolean hasTargetModeRetry() {
+      return ((bitField0_ & 0x00000080) == 0x00000080);
+    }
+    public int getTargetModeRetry() {
+      return targetModeRetry_;
+    }
+    
+    // optional bytes touch_to_push_ms = 9;
+    public static final int TOUCH_TO_PUSH_MS_FIELD_NUMBER = 9;
+    private com.google.protobuf.ByteString touchToPushMs_;
+    public boolean hasTouchToPushMs() {
+      return ((bitField0_ & 0x00000100) == 0x00000100);
+    }
+    public com.google.protobuf.ByteString getTouchToPushMs() {
+      return touchToPushMs_;
+    }
+    
+    // optional bytes poll_to_detect_ms = 10;
+    public static final int POLL_TO_DETECT_MS_FIELD_NUMBER = 10;
+    private com.google.protobuf.ByteString pollToDetectMs_;
+    public boolean hasPollToDetectMs() {
+      return ((bitField0_ & 0x00000200) == 0x00000200);
+    }
+    public com.google.protobuf.ByteString getPollToDetectMs() {
+      return pollToDetectMs_;
+    }
+    
+    // optional bytes llcp_session_ms = 11;
+    public static final int LLCP_SESSION_MS_FIELD_NUMBER = 11;
+    private com.google.protobuf.ByteString llcpSessionMs_;
+    public boolean hasLlcpSessionMs() {
+      return ((bitField0_ & 0x00000400) == 0x00000400);
+    }
+    public com.google.protobuf.ByteString getLlcpSessionMs() {
+      return llcpSessionMs_;
+    }
+    
     private void initFields() {
       numberSerialFailure_ = 0;
       numberWatchdog_ = 0;
@@ -131,6 +201,11 @@ public final class NfcSmartTag {
       numberExternalReset_ = 0;
       numberPowerReset_ = 0;
       batteryVoltage_ = 0;
+      pollIntervalMs_ = 0;
+      targetModeRetry_ = 0;
+      touchToPushMs_ = com.google.protobuf.ByteString.EMPTY;
+      pollToDetectMs_ = com.google.protobuf.ByteString.EMPTY;
+      llcpSessionMs_ = com.google.protobuf.ByteString.EMPTY;
     }
     private byte memoizedIsInitialized = -1;
     public final boolean isInitialized() {
@@ -162,6 +237,21 @@ public final class NfcSmartTag {
       if (((bitField0_ & 0x00000020) == 0x00000020)) {
         output.writeUInt32(6, batteryVoltage_);
       }
+      if (((bitField0_ & 0x00000040) == 0x00000040)) {
+        output.writeUInt32(7, pollIntervalMs_);
+      }
+      if (((bitField0_ & 0x00000080) == 0x00000080)) {
+        output.writeUInt32(8, targetModeRetry_);
+      }
+      if (((bitField0_ & 0x00000100) == 0x00000100)) {
+        output.writeBytes(9, touchToPushMs_);
+      }
+      if (((bitField0_ & 0x00000200) == 0x00000200)) {
+        output.writeBytes(10, pollToDetectMs_);
+      }
+      if (((bitField0_ & 0x00000400) == 0x00000400)) {
+        output.writeBytes(11, llcpSessionMs_);
+      }
       getUnknownFields().writeTo(output);
     }
     
@@ -195,6 +285,26 @@ public final class NfcSmartTag {
         size += com.google.protobuf.CodedOutputStream
           .computeUInt32Size(6, batteryVoltage_);
       }
+      if (((bitField0_ & 0x00000040) == 0x00000040)) {
+        size += com.google.protobuf.CodedOutputStream
+          .computeUInt32Size(7, pollIntervalMs_);
+      }
+      if (((bitField0_ & 0x00000080) == 0x00000080)) {
+        size += com.google.protobuf.CodedOutputStream
+          .computeUInt32Size(8, targetModeRetry_);
+      }
+      if (((bitField0_ & 0x00000100) == 0x00000100)) {
+        size += com.google.protobuf.CodedOutputStream
+          .computeBytesSize(9, touchToPushMs_);
+      }
+      if (((bitField0_ & 0x00000200) == 0x00000200)) {
+        size += com.google.protobuf.CodedOutputStream
+          .computeBytesSize(10, pollToDetectMs_);
+      }
+      if (((bitField0_ & 0x00000400) == 0x00000400)) {
+        size += com.google.protobuf.CodedOutputStream
+          .computeBytesSize(11, llcpSessionMs_);
+      }
       size += getUnknownFields().getSerializedSize();
       memoizedSerializedSize = size;
       return size;
@@ -331,6 +441,16 @@ public final class NfcSmartTag {
         bitField0_ = (bitField0_ & ~0x00000010);
         batteryVoltage_ = 0;
         bitField0_ = (bitField0_ & ~0x00000020);
+        pollIntervalMs_ = 0;
+        bitField0_ = (bitField0_ & ~0x00000040);
+        targetModeRetry_ = 0;
+        bitField0_ = (bitField0_ & ~0x00000080);
+        touchToPushMs_ = com.google.protobuf.ByteString.EMPTY;
+        bitField0_ = (bitField0_ & ~0x00000100);
+        pollToDetectMs_ = com.google.protobuf.ByteString.EMPTY;
+        bitField0_ = (bitField0_ & ~0x00000200);
+        llcpSessionMs_ = com.google.protobuf.ByteString.EMPTY;
+        bitField0_ = (bitField0_ & ~0x00000400);
         return this;
       }
       
@@ -393,6 +513,26 @@ public final class NfcSmartTag {
           to_bitField0_ |= 0x00000020;
         }
         result.batteryVoltage_ = batteryVoltage_;
+        if (((from_bitField0_ & 0x00000040) == 0x00000040)) {
+          to_bitField0_ |= 0x00000040;
+        }
+        result.pollIntervalMs_ = pollIntervalMs_;
+        if (((from_bitField0_ & 0x00000080) == 0x00000080)) {
+          to_bitField0_ |= 0x00000080;
+        }
+        result.targetModeRetry_ = targetModeRetry_;
+        if (((from_bitField0_ & 0x00000100) == 0x00000100)) {
+          to_bitField0_ |= 0x00000100;
+        }
+        result.touchToPushMs_ = touchToPushMs_;
+        if (((from_bitField0_ & 0x00000200) == 0x00000200)) {
+          to_bitField0_ |= 0x00000200;
+        }
+        result.pollToDetectMs_ = pollToDetectMs_;
+        if (((from_bitField0_ & 0x00000400) == 0x00000400)) {
+          to_bitField0_ |= 0x00000400;
+        }
+        result.llcpSessionMs_ = llcpSessionMs_;
         result.bitField0_ = to_bitField0_;
         onBuilt();
         return result;
@@ -427,6 +567,21 @@ public final class NfcSmartTag {
         if (other.hasBatteryVoltage()) {
           setBatteryVoltage(other.getBatteryVoltage());
         }
+        if (other.hasPollIntervalMs()) {
+          setPollIntervalMs(other.getPollIntervalMs());
+        }
+        if (other.hasTargetModeRetry()) {
+          setTargetModeRetry(other.getTargetModeRetry());
+        }
+        if (other.hasTouchToPushMs()) {
+          setTouchToPushMs(other.getTouchToPushMs());
+        }
+        if (other.hasPollToDetectMs()) {
+          setPollToDetectMs(other.getPollToDetectMs());
+        }
+        if (other.hasLlcpSessionMs()) {
+          setLlcpSessionMs(other.getLlcpSessionMs());
+        }
         this.mergeUnknownFields(other.getUnknownFields());
         return this;
       }
@@ -488,6 +643,31 @@ public final class NfcSmartTag {
               batteryVoltage_ = input.readUInt32();
               break;
             }
+            case 56: {
+              bitField0_ |= 0x00000040;
+              pollIntervalMs_ = input.readUInt32();
+              break;
+            }
+            case 64: {
+              bitField0_ |= 0x00000080;
+              targetModeRetry_ = input.readUInt32();
+              break;
+            }
+            case 74: {
+              bitField0_ |= 0x00000100;
+              touchToPushMs_ = input.readBytes();
+              break;
+            }
+            case 82: {
+              bitField0_ |= 0x00000200;
+              pollToDetectMs_ = input.readBytes();
+              break;
+            }
+            case 90: {
+              bitField0_ |= 0x00000400;
+              llcpSessionMs_ = input.readBytes();
+              break;
+            }
           }
         }
       }
@@ -620,6 +800,120 @@ public final class NfcSmartTag {
         return this;
       }
       
+      // optional uint32 poll_interval_ms = 7;
+      private int pollIntervalMs_ ;
+      public boolean hasPollIntervalMs() {
+        return ((bitField0_ & 0x00000040) == 0x00000040);
+      }
+      public int getPollIntervalMs() {
+        return pollIntervalMs_;
+      }
+      public Builder setPollIntervalMs(int value) {
+        bitField0_ |= 0x00000040;
+        pollIntervalMs_ = value;
+        onChanged();
+        return this;
+      }
+      public Builder clearPollIntervalMs() {
+        bitField0_ = (bitField0_ & ~0x00000040);
+        pollIntervalMs_ = 0;
+        onChanged();
+        return this;
+      }
+      
+      // optional uint32 target_mode_retry = 8;
+      private int targetModeRetry_ ;
+      public boolean hasTargetModeRetry() {
+        return ((bitField0_ & 0x00000080) == 0x00000080);
+      }
+      public int getTargetModeRetry() {
+        return targetModeRetry_;
+      }
+      public Builder setTargetModeRetry(int value) {
+        bitField0_ |= 0x00000080;
+        targetModeRetry_ = value;
+        onChanged();
+        return this;
+      }
+      public Builder clearTargetModeRetry() {
+        bitField0_ = (bitField0_ & ~0x00000080);
+        targetModeRetry_ = 0;
+        onChanged();
+        return this;
+      }
+      
+      // optional bytes touch_to_push_ms = 9;
+      private com.google.protobuf.ByteString touchToPushMs_ = com.google.protobuf.ByteString.EMPTY;
+      public boolean hasTouchToPushMs() {
+        return ((bitField0_ & 0x00000100) == 0x00000100);
+      }
+      public com.google.protobuf.ByteString getTouchToPushMs() {
+        return touchToPushMs_;
+      }
+      public Builder setTouchToPushMs(com.google.protobuf.ByteString value) {
+        if (value == null) {
+    throw new NullPointerException();
+  }
+  bitField0_ |= 0x00000100;
+        touchToPushMs_ = value;
+        onChanged();
+        return this;
+      }
+      public Builder clearTouchToPushMs() {
+        bitField0_ = (bitField0_ & ~0x00000100);
+        touchToPushMs_ = getDefaultInstance().getTouchToPushMs();
+        onChanged();
+        return this;
+      }
+      
+      // optional bytes poll_to_detect_ms = 10;
+      private com.google.protobuf.ByteString pollToDetectMs_ = com.google.protobuf.ByteString.EMPTY;
+      public boolean hasPollToDetectMs() {
+        return ((bitField0_ & 0x00000200) == 0x00000200);
+      }
+      public com.google.protobuf.ByteString getPollToDetectMs() {
+        return pollToDetectMs_;
+      }
+      public Builder setPollToDetectMs(com.google.protobuf.ByteString value) {
+        if (value == null) {
+    throw new NullPointerException();
+  }
+  bitField0_ |= 0x00000200;
+        pollToDetectMs_ = value;
+        onChanged();
+        return this;
+      }
+      public Builder clearPollToDetectMs() {
+        bitField0_ = (bitField0_ & ~0x00000200);
+        pollToDetectMs_ = getDefaultInstance().getPollToDetectMs();
+        onChanged();
+        return this;
+      }
+      
+      // optional bytes llcp_session_ms = 11;
+      private com.google.protobuf.ByteString llcpSessionMs_ = com.google.protobuf.ByteString.EMPTY;
+      public boolean hasLlcpSessionMs() {
+        return ((bitField0_ & 0x00000400) == 0x00000400);
+      }
+      public com.google.protobuf.ByteString getLlcpSessionMs() {
+        return llcpSessionMs_;
+      }
+      public Builder setLlcpSessionMs(com.google.protobuf.ByteString value) {
+        if (value == null) {
+    throw new NullPointerException();
+  }
+  bitField0_ |= 0x00000400;
+        llcpSessionMs_ = value;
+        onChanged();
+        return this;
+      }
+      public Builder clearLlcpSessionMs() {
+        bitField0_ = (bitField0_ & ~0x00000400);
+        llcpSessionMs_ = getDefaultInstance().getLlcpSessionMs();
+        onChanged();
+        return this;
+      }
+      
       // @@protoc_insertion_point(builder_scope:NfcSmartTagInfo)
     }
     
@@ -645,12 +939,15 @@ public final class NfcSmartTag {
       descriptor;
   static {
     java.lang.String[] descriptorData = {
-      "\n\023nfc_smart_tag.proto\"\267\001\n\017NfcSmartTagInf" +
+      "\n\023nfc_smart_tag.proto\"\272\002\n\017NfcSmartTagInf" +
       "o\022\035\n\025number_serial_failure\030\001 \001(\r\022\027\n\017numb" +
       "er_watchdog\030\002 \001(\r\022\030\n\020number_brown_out\030\003 " +
       "\001(\r\022\035\n\025number_external_reset\030\004 \001(\r\022\032\n\022nu" +
       "mber_power_reset\030\005 \001(\r\022\027\n\017battery_voltag" +
-      "e\030\006 \001(\r"
+      "e\030\006 \001(\r\022\030\n\020poll_interval_ms\030\007 \001(\r\022\031\n\021tar" +
+      "get_mode_retry\030\010 \001(\r\022\030\n\020touch_to_push_ms" +
+      "\030\t \001(\014\022\031\n\021poll_to_detect_ms\030\n \001(\014\022\027\n\017llc" +
+      "p_session_ms\030\013 \001(\014"
     };
     com.google.protobuf.Descriptors.FileDescriptor.InternalDescriptorAssigner assigner =
       new com.google.protobuf.Descriptors.FileDescriptor.InternalDescriptorAssigner() {
@@ -662,7 +959,7 @@ public final class NfcSmartTag {
           internal_static_NfcSmartTagInfo_fieldAccessorTable = new
             com.google.protobuf.GeneratedMessage.FieldAccessorTable(
               internal_static_NfcSmartTagInfo_descriptor,
-              new java.lang.String[] { "NumberSerialFailure", "NumberWatchdog", "NumberBrownOut", "NumberExternalReset", "NumberPowerReset", "BatteryVoltage", },
+              new java.lang.String[] { "NumberSerialFailure", "NumberWatchdog", "NumberBrownOut", "NumberExternalReset", "NumberPowerReset", "BatteryVoltage", "PollIntervalMs", "TargetModeRetry", "TouchToPushMs", "PollToDetectMs", "LlcpSessionMs", },
               NfcSmartTag.NfcSmartTagInfo.class,
               NfcSmartTag.NfcSmartTagInfo.Builder.class);
           return null;
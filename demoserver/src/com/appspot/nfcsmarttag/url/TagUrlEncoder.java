@@ -35,9 +35,11 @@ import org.keyczar.util.Base64Coder;
  * FeliCa ID (64 bit)
  * counter (32 bit)
  * all zero or other well-known content (32 bit)
+ * Checksum is the first 64 bits of a SHA1 hash (version 2) or of an
+ * AES-CMAC (version 3).
  * Transmitted without encryption:
  * tag id (64 bit)
- * reserved (8 bit)
+ * version (8 bit)
  */
 public class TagUrlEncoder {
   private String encodedValue;
@@ -46,11 +48,10 @@ public class TagUrlEncoder {
   private long counter;
   private byte[] tagKey;
   private NfcSmartTag.NfcSmartTagInfo nfcSmartTagInfo;
+  private byte version;
 
   private boolean isEncoded;
   private boolean isError;
-  
-  private static final byte RESERVED = 2;
 
   /**
    * TagUrlEncoder.
@@ -75,11 +76,30 @@ public class TagUrlEncoder {
    */
   public TagUrlEncoder(byte[] idm, byte[] tagId, long counter,
       byte[] tagKey, NfcSmartTag.NfcSmartTagInfo nfcSmartTagInfo) {
+    this(idm, tagId, counter, tagKey, nfcSmartTagInfo, Url4Tag.VERSION_SHA1);
+  }
+
+  /**
+   * TagUrlEncoder.
+   *
+   * @param idm the IDm value to encode.
+   * @param tagId the tag's id to encode.
+   * @param counter the tag's counter value to encode.
+   * @param tagKey the tag's key to be used at encoding.
+   * @param version the URL version, {@link Url4Tag#VERSION_SHA1} or
+   *        {@link Url4Tag#VERSION_CMAC}.
+   */
+  public TagUrlEncoder(byte[] idm, byte[] tagId, long counter,
+      byte[] tagKey, NfcSmartTag.NfcSmartTagInfo nfcSmartTagInfo, byte version) {
+    if (version != Url4Tag.VERSION_SHA1 && version != Url4Tag.VERSION_CMAC) {
+      throw new IllegalArgumentException("Unknown URL version " + version);
+    }
     this.idm = idm;
     this.tagId = tagId;
     this.counter = counter;
     this.tagKey = tagKey;
     this.nfcSmartTagInfo = nfcSmartTagInfo;
+    this.version = version;
     this.isEncoded = false;
     this.isError = false;
   }
@@ -114,7 +134,7 @@ public class TagUrlEncoder {
     System.arraycopy(smartTagBytes, 0, value, head, smartTagBytes.length);
     head += smartTagBytes.length;
 
-    System.arraycopy(Utils.hash(value, 0, head, 8), 0, value, head, 8);
+    System.arraycopy(Url4Tag.checksum(version, tagKey, value, head, 8), 0, value, head, 8);
     head += 8;
 
     byte[] nonce = new byte[16];
@@ -128,7 +148,7 @@ public class TagUrlEncoder {
       throw new InvalidInputException(e);
     }
 
-    value[head] = RESERVED;
+    value[head] = version;
     head += 1;
 
     byte[] tmp = new byte[head];
@@ -40,19 +40,26 @@ public class Url4Tag {
   private final byte[] idm;
   private final long counter;
   private final NfcSmartTag.NfcSmartTagInfo nfcSmartTagInfo;
+  private final LatencyHistogram latencyHistogram;
 
   public static final int IDM_LENGTH = 8;
   public static final int STATION_ID_LENGTH = 8;
 
+  /** URL version with the first 64 bits of a SHA1 hash as checksum. */
+  public static final byte VERSION_SHA1 = 2;
+  /** URL version with the first 64 bits of an AES-CMAC as checksum. */
+  public static final byte VERSION_CMAC = 3;
+
   /**
    * Use {@link #fromEncodedValue(SmartTagKeyStoreInterface, String)} to get an instance.
    */
   protected Url4Tag(byte[] tagId, byte[] idm, long counter,
-      NfcSmartTag.NfcSmartTagInfo nfcSmartTagInfo) {
+      NfcSmartTag.NfcSmartTagInfo nfcSmartTagInfo, LatencyHistogram latencyHistogram) {
     this.tagId = tagId;
     this.idm = idm;
     this.counter = counter;
     this.nfcSmartTagInfo = nfcSmartTagInfo;
+    this.latencyHistogram = latencyHistogram;
   }
 
   private static boolean isEmptyOrWhitespace(String string) {
@@ -113,8 +120,10 @@ public class Url4Tag {
      * 0x08  : Counter (4 bytes, encrypted)
      * 0x0c  : Felica ID (8 bytes, encrypted)
      * 0x14  : arbitrary data(n bytes, encrypted)
-     * 0x14+n: First 64 bits of SHA1 hash value (8 bytes, encrypted)
-     * 0x1c+n: reserved (1 byte)
+     * 0x14+n: Checksum (8 bytes, encrypted), first 64 bits of
+     *         - SHA1 hash value for version 2
+     *         - AES-CMAC value for version 3
+     * 0x1c+n: version (1 byte)
      */
     final int STATION_ID_POSITION = 0x00;
     final int COUNTER_POSITION = 0x08;
@@ -124,6 +133,15 @@ public class Url4Tag {
     final int STATION_INFO_POSITION = 0x14;
     final int CHECKSUM_SIZE = 0x08;
     final int RESERVED_SIZE = 0x01;
+    final int MIN_SIZE = STATION_INFO_POSITION + CHECKSUM_SIZE + RESERVED_SIZE;
+
+    if (value.length < MIN_SIZE) {
+      throw new InvalidInputException("URL value too short: " + value.length + " bytes");
+    }
+    byte version = value[value.length - RESERVED_SIZE];
+    if (version != VERSION_SHA1 && version != VERSION_CMAC) {
+      throw new InvalidInputException("Unknown URL version " + version);
+    }
 
     byte[] tagId = new byte[STATION_ID_LENGTH];
     System.arraycopy(value, STATION_ID_POSITION, tagId, 0, tagId.length);
@@ -149,8 +167,8 @@ public class Url4Tag {
       byte[] checkSum = new byte[CHECKSUM_SIZE];
       System.arraycopy(tmp, tmp.length - RESERVED_SIZE - CHECKSUM_SIZE, checkSum, 0,
           checkSum.length);
-      byte[] digest = Utils.hash(tmp, 0, tmp.length - RESERVED_SIZE - CHECKSUM_SIZE,
-          checkSum.length);
+      byte[] digest = checksum(version, tagKey, tmp,
+          tmp.length - RESERVED_SIZE - CHECKSUM_SIZE, checkSum.length);
       if (Arrays.equals(checkSum, digest)) {
         byte[] idm = new byte[IDM_LENGTH];
         System.arraycopy(tmp, IDM_POSITION, idm, 0, idm.length);
@@ -159,13 +177,31 @@ public class Url4Tag {
         byte[] payload = new byte[payload_length];
         System.arraycopy(tmp, STATION_INFO_POSITION, payload, 0, payload_length);
         NfcSmartTag.NfcSmartTagInfo nfcSmartTagInfo = NfcSmartTag.NfcSmartTagInfo.parseFrom(payload);
-        
-        return new Url4Tag(tagId, idm, counter, nfcSmartTagInfo);
+        LatencyHistogram latencyHistogram = LatencyHistogram.fromInfo(nfcSmartTagInfo);
+
+        return new Url4Tag(tagId, idm, counter, nfcSmartTagInfo, latencyHistogram);
       }
     }
     throw new InvalidInputException("Cannot find the tag key to decode.");
   }
 
+  /**
+   * Calculates the checksum of a URL version over the plain text.
+   *
+   * @param version URL version, {@link #VERSION_SHA1} or {@link #VERSION_CMAC}.
+   * @param key the tag key. Version 3 uses a MAC key derived from it.
+   * @param source bytes to calc checksum, starting at position 0.
+   * @param sourceLength length to calc checksum.
+   * @param size the size of checksum.
+   * @return checksum calculated from given source.
+   */
+  static byte[] checksum(byte version, byte[] key, byte[] source, int sourceLength, int size) {
+    if (version == VERSION_CMAC) {
+      return Utils.cmac(Utils.macKey(key), source, 0, sourceLength, size);
+    }
+    return Utils.hash(source, 0, sourceLength, size);
+  }
+
   /**
    * Returns a tag id.
    *
@@ -202,6 +238,15 @@ public class Url4Tag {
     return nfcSmartTagInfo;
   }
 
+  /**
+   * Returns the latency histogram come from the smart tag.
+   *
+   * @return the histogram, or null if the URL carries none.
+   */
+  public LatencyHistogram getLatencyHistogram() {
+    return latencyHistogram;
+  }
+
   /**
    * Decrypt the AES block cipher.
    * CAUTION: decryption will overwrite the original buffer!!!
@@ -21,8 +21,11 @@ import java.security.InvalidAlgorithmParameterException;
 import java.security.InvalidKeyException;
 import java.security.MessageDigest;
 import java.security.NoSuchAlgorithmException;
+import java.util.Arrays;
 
+import javax.crypto.BadPaddingException;
 import javax.crypto.Cipher;
+import javax.crypto.IllegalBlockSizeException;
 import javax.crypto.NoSuchPaddingException;
 import javax.crypto.spec.IvParameterSpec;
 import javax.crypto.spec.SecretKeySpec;
@@ -85,6 +88,104 @@ public class Utils {
     }
   }
 
+  /**
+   * Derive the key a station uses for AES-CMAC from its tag key: the tag
+   * key encrypted with an all ones block. CMAC and the CTR encryption of
+   * the same URL must not share a key.
+   *
+   * @param key the tag key.
+   * @return the MAC key.
+   */
+  public static byte[] macKey(byte[] key) {
+    try {
+      Cipher cipher = setUpAesEcbCipher(key, Cipher.ENCRYPT_MODE);
+      byte[] allOnes = new byte[16];
+      Arrays.fill(allOnes, (byte) 0xff);
+      return cipher.doFinal(allOnes);
+    } catch (IllegalBlockSizeException e) {
+      // may not occur.
+      throw new IllegalStateException(e);
+    } catch (BadPaddingException e) {
+      // may not occur.
+      throw new IllegalStateException(e);
+    }
+  }
+
+  /**
+   * Calc AES-CMAC (RFC 4493) value with specified size.
+   *
+   * @param key a secret key for the MAC.
+   * @param source bytes to calc MAC.
+   * @param sourcePosition position to start calc.
+   * @param sourceLength length to calc MAC.
+   * @param size the size of MAC.
+   * @return MAC value calculated from given source.
+   */
+  public static byte[] cmac(byte[] key, byte[] source, int sourcePosition, int sourceLength,
+      int size) {
+    final int BLOCK_SIZE = 16;
+    try {
+      Cipher cipher = setUpAesEcbCipher(key, Cipher.ENCRYPT_MODE);
+      byte[] k1 = cmacDouble(cipher.doFinal(new byte[BLOCK_SIZE]));
+      byte[] k2 = cmacDouble(k1);
+      byte[] mac = new byte[BLOCK_SIZE];
+      int i = 0;
+
+      // CBC over all blocks but the last.
+      for (; sourceLength - i > BLOCK_SIZE; i += BLOCK_SIZE) {
+        for (int j = 0; j < BLOCK_SIZE; j++) {
+          mac[j] ^= source[sourcePosition + i + j];
+        }
+        mac = cipher.doFinal(mac);
+      }
+
+      // last block: K1 if complete, else padded with 10...0 and K2.
+      int remain = sourceLength - i;
+      byte[] subkey = k1;
+      for (int j = 0; j < remain; j++) {
+        mac[j] ^= source[sourcePosition + i + j];
+      }
+      if (remain < BLOCK_SIZE) {
+        mac[remain] ^= (byte) 0x80;
+        subkey = k2;
+      }
+      for (int j = 0; j < BLOCK_SIZE; j++) {
+        mac[j] ^= subkey[j];
+      }
+      mac = cipher.doFinal(mac);
+
+      byte[] digest = new byte[size];
+      System.arraycopy(mac, 0, digest, 0, digest.length);
+      return digest;
+    } catch (IllegalBlockSizeException e) {
+      // may not occur.
+      throw new IllegalStateException(e);
+    } catch (BadPaddingException e) {
+      // may not occur.
+      throw new IllegalStateException(e);
+    }
+  }
+
+  /**
+   * Multiply a 128 bit block by x in GF(2^128), for the CMAC subkeys.
+   *
+   * @param block the block to multiply.
+   * @return a new block holding the product.
+   */
+  private static byte[] cmacDouble(byte[] block) {
+    byte[] result = new byte[block.length];
+    int carry = 0;
+    for (int i = block.length - 1; i >= 0; i--) {
+      int b = block[i] & 0xff;
+      result[i] = (byte) ((b << 1) | carry);
+      carry = b >>> 7;
+    }
+    if (carry != 0) {
+      result[block.length - 1] ^= (byte) 0x87;
+    }
+    return result;
+  }
+
   public static Cipher setUpAesEcbCipher(byte[] key, int mode) {
     try {
       Cipher cipher = Cipher.getInstance("AES/ECB/NoPadding");
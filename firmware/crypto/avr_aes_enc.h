@@ -40,4 +40,9 @@ void aes128_init(uint8_t *key, aes128_ctx_t *ctx);
 // Encodes one 16 byte (128bit) block of data in place.
 void aes128_enc(uint8_t *block, aes128_ctx_t *ctx);
 
+#ifdef WITH_AES_ASM
+// C version of aes128_enc when the assembly version is linked.
+void aes128_enc_c(uint8_t *block, aes128_ctx_t *ctx);
+#endif
+
 #endif  // EXPERIMENTAL_NFC_AVR_BASE_AVR_AES_ENC_H_
@@ -66,6 +66,7 @@ static void SHA1ProcessMessageBlock(SHA1Context *);
  * Optimized version of a cyclic left shift by 5.
  */
 static uint32_t SHA1CircularShift5(uint32_t word) {
+#ifdef __AVR__
  uint8_t count = 5;
 
  asm volatile(
@@ -79,12 +80,16 @@ static uint32_t SHA1CircularShift5(uint32_t word) {
       "BRNE L_%=\n\t"
       : "+d" (word) : "r" (count) : "r20");
   return word;
+#else /* !__AVR__ */
+  return SHA1CircularShift(5, word);
+#endif /* __AVR__ */
 }
 
 /*
  * Optimized version of a cyclic left shift by 30.
  */
 static uint32_t SHA1CircularShift30(uint32_t word) {
+#ifdef __AVR__
  uint8_t count = 2; // Shift right 2 instead of 30 left
 
  asm volatile(
@@ -98,6 +103,9 @@ static uint32_t SHA1CircularShift30(uint32_t word) {
       "BRNE L_%=\n\t"
       : "+d" (word) : "r" (count) : "r20");
   return word;
+#else /* !__AVR__ */
+  return SHA1CircularShift(30, word);
+#endif /* __AVR__ */
 }
 
 /*
@@ -105,6 +113,7 @@ static uint32_t SHA1CircularShift30(uint32_t word) {
  * or vice versa.
  */
 static uint32_t swap32(uint32_t value) {
+#ifdef __AVR__
   asm volatile(
       "mov __tmp_reg__, %A0" "\n\t"
       "mov %A0, %D0"         "\n\t"
@@ -114,6 +123,10 @@ static uint32_t swap32(uint32_t value) {
       "mov %C0, __tmp_reg__" "\n\t"
       : "+r" (value));
   return value;
+#else /* !__AVR__ */
+  return (value >> 24) | ((value >> 8) & 0xff00) |
+         ((value << 8) & 0xff0000) | (value << 24);
+#endif /* __AVR__ */
 }
 
 /*
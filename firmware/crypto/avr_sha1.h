@@ -9,4 +9,12 @@ typedef uint8_t sha1_hash_t[SHA1HashSize];
 
 void sha1(sha1_hash_t hash, uint8_t *buffer, uint16_t buffer_size);
 
+#ifdef WITH_SHA1_ASM
+// Longest message that fits in a single block with its padding.
+#define SHA1_SHORT_MAX 55
+
+// sha1 for messages of up to SHA1_SHORT_MAX bytes (crypto/avr_sha1_asm.S).
+void sha1_short(sha1_hash_t hash, uint8_t *buffer, uint8_t buffer_size);
+#endif
+
 #endif  // EXPERIMENTAL_NFC_AVR_BASE_AVR_SHA1_H_
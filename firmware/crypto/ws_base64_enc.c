@@ -16,8 +16,11 @@
  * Web safe base64 encoding.
  */
 
+#include <avr/pgmspace.h>
+
 #include "ws_base64_enc.h"
 
+#ifdef SMALL_BASE64
 /*
  * Represent 6bits data as a safe ASCII character.
  */
@@ -35,11 +38,29 @@ number2ascii(uint8_t num)
   else
     return '_';
 }
+#else /* !SMALL_BASE64 */
+static const char alphabet[64] PROGMEM = {
+  'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
+  'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
+  'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm',
+  'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
+  '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '-', '_'
+};
+
+/*
+ * Represent 6bits data as a safe ASCII character.
+ */
+#define number2ascii(num) ((char)pgm_read_byte(&alphabet[(num)]))
+#endif /* SMALL_BASE64 */
 
 /*
- * Encodes a data block in web safe base 64 encoding.
+ * Encodes a data block in web safe base 64 encoding, without padding.
  * Returns true on success, false if the output buffer size is
- * insufficient.
+ * insufficient. Nothing is written in that case.
+ *
+ * Encoding in place is allowed: input may lie inside output if it starts
+ * at least (input_size + 2) / 3 bytes after output. Each 3 bytes are read
+ * before their 4 characters are written.
  *
  * output: Output buffer receiving the encoded string, null terminated
  * output_size: Size of the output buffer in bytes
@@ -50,39 +71,41 @@ bool
 websafe_base64_encode(char output[], int output_size,
                       const uint8_t input[], int input_size)
 {
-  int i, j;
-  uint8_t pos;
-  uint8_t cur, rem;
+  int i;
+  uint8_t a, b, c;
+
+  if ((input_size * 4 + 2) / 3 >= output_size) /* exceed size */
+    return false;
 
-  pos = cur = rem = 0;
-  for (i = 0, j = -1; i < input_size; i++) {
-    switch (pos) {
-      case 0:
-        if (j >= output_size - 1) /* exceed size */
-          return false;
-        j++;
-        cur = (input[i] >> 2);
-        rem = (input[i] & 0x03) << 4;
-        break;
-      case 1:
-        cur = rem | (input[i] >> 4);
-        rem = (input[i] & 0x0f) << 2;
-        break;
-      case 2:
-        cur = rem | (input[i] >> 6);
-        rem = input[i] & 0x3f;
-        break;
-    }
-    if (j >= output_size - 1) /* exceed size */
-      return false;
-    output[j++] = number2ascii(cur);
-    output[j] = number2ascii(rem);
-    pos = (pos == 2) ? 0 : (pos + 1);
+  /* 3 bytes to 4 characters */
+  for (i = input_size / 3; i > 0; i--) {
+    a = input[0];
+    b = input[1];
+    c = input[2];
+    output[0] = number2ascii(a >> 2);
+    output[1] = number2ascii(((a & 0x03) << 4) | (b >> 4));
+    output[2] = number2ascii(((b & 0x0f) << 2) | (c >> 6));
+    output[3] = number2ascii(c & 0x3f);
+    input += 3;
+    output += 4;
   }
 
-  if (j >= output_size - 1) /* exceed size */
-    return false;
-  output[++j] = '\0';
+  /* 1 or 2 bytes left: 2 or 3 characters */
+  switch (input_size % 3) {
+    case 1:
+      a = input[0];
+      *output++ = number2ascii(a >> 2);
+      *output++ = number2ascii((a & 0x03) << 4);
+      break;
+    case 2:
+      a = input[0];
+      b = input[1];
+      *output++ = number2ascii(a >> 2);
+      *output++ = number2ascii(((a & 0x03) << 4) | (b >> 4));
+      *output++ = number2ascii((b & 0x0f) << 2);
+      break;
+  }
+  *output = '\0';
 
   return true;
 }
@@ -26,18 +26,28 @@
 #include <string.h>
 
 #include "peripheral/eeprom.h"
+#include "peripheral/eeprom_queue.h"
+#include "poll_schedule.h"
+#include "trace.h"
 
 #include "eeprom_data.h"
 
 // Use a bit combination that is unlikely to happen by accident
 #define CONFIG_MARKER 0xa5
 
+// One slot of the touch counter ring. check is CONFIG_MARKER xor the
+// value bytes, so erased, zeroed and most torn slots are invalid.
+typedef struct {
+  uint32_t value;
+  uint8_t check;
+} counter_slot_t;
+
 // Data structure stored in EEPROM
 typedef struct {
   /* number of usart failures */
   uint32_t number_usart_fail;
 
-  /* station counter (stores number of touches) */
+  /* station counter before counter_ring, seeds the ring */
   uint32_t counter;
 
   /* station is configured if value is CONFIG_MARKER */
@@ -58,6 +68,17 @@ typedef struct {
 
   uint8_t flags;
 
+  /* Decayed touch counts per kind of phone, see poll_schedule.c */
+  uint8_t touch_weights[NUM_TOUCH_KINDS];
+  /* CONFIG_MARKER xor touch_weights, so erased cells read as no touches */
+  uint8_t touch_weights_check;
+
+  /* station counter (stores number of touches), highest valid slot wins */
+  counter_slot_t counter_ring[COUNTER_SLOTS];
+
+  /* Last trace saved by trace_save() */
+  uint8_t trace[TRACE_PAGE_BYTES];
+
   /* Add new fields here */
 } stats_t;
 
@@ -72,6 +93,59 @@ static stats_t __attribute__((section(".eeprom"))) stats = {
 //                   0x24, 0x55, 0x3A, 0x01, 0xB3, 0x0E, 0x7F, 0x46 },
 };
 
+// Counters mirrored in RAM, see eeprom_load_stats()
+enum {
+  MIRROR_USART_FAIL,
+  MIRROR_PORF,
+  MIRROR_EXTRF,
+  MIRROR_BORF,
+  MIRROR_WDRF,
+  NUM_MIRRORED
+};
+
+static bool mirror_loaded;
+static uint32_t mirror[NUM_MIRRORED];
+static uint16_t mirror_dirty;
+static bool mirror_changed = true;
+
+// Station counter in RAM. Values up to counter_durable are reserved in
+// EEPROM and can be handed out without waiting for it.
+static bool counter_loaded;
+static uint32_t counter;
+static uint32_t counter_reserved;
+static uint32_t counter_durable;
+static uint8_t counter_next_slot;
+
+/*
+ * Reads EEPROM once queued writes are done.
+ */
+static uint8_t __read_byte(const uint8_t *addr)
+{
+  eeprom_queue_flush();
+  return eeprom_read_byte(addr);
+}
+
+static uint32_t __read_dword(const uint32_t *addr)
+{
+  eeprom_queue_flush();
+  return eeprom_read_dword(addr);
+}
+
+static void __read_block(void *dst, const void *src, size_t n)
+{
+  eeprom_queue_flush();
+  eeprom_read_block(dst, src, n);
+}
+
+/*
+ * Queues a write of stats fields, traced.
+ */
+static void __write(void *dst, const void *src, uint8_t len)
+{
+  trace(TRACE_EEPROM_WRITE, len);
+  eeprom_queue_write(dst, src, len);
+}
+
 /*
  * Increases counters based on reset status flags.
  */
@@ -84,6 +158,8 @@ void eeprom_count_mcusr(uint8_t mcusr)
    * BORF  brown-out reset flag.
    * WDRF  watch dog system reset flag.
    */
+  // Called from .init3: RAM is not initialized yet and interrupts are off
+  eeprom_queue_init();
   if ((mcusr & _BV(PORF)) != 0)
     (void)increment_eeprom_uint32(&stats.number_porf);
   else if ((mcusr & _BV(BORF)) != 0)
@@ -100,6 +176,8 @@ void eeprom_count_mcusr(uint8_t mcusr)
       (void)increment_eeprom_uint32(&stats.number_wdrf);
     }
   }
+  // Clearing .bss would drop the queue
+  eeprom_queue_flush();
 }
 
 /*
@@ -111,7 +189,7 @@ bool eeprom_has_station_info(void)
 {
   uint8_t has_station_info;
 
-  has_station_info = eeprom_read_byte(&stats.has_station_info);
+  has_station_info = __read_byte(&stats.has_station_info);
   EEAR = (uint16_t)(&stats.unused);
   return has_station_info == CONFIG_MARKER;
 }
@@ -126,60 +204,259 @@ void eeprom_write_station_info(uint8_t station_id[STATION_ID_BYTES],
   memcpy(&new_stats.station_id, station_id, STATION_ID_BYTES);
   memcpy(&new_stats.station_key, station_key, STATION_KEY_BYTES);
 
+  eeprom_queue_flush();
   eeprom_write_block(&new_stats, &stats, sizeof(stats));
+  counter_loaded = false;
+  mirror_loaded = false;
+  mirror_dirty = 0;
+  mirror_changed = true;
 }
 
 void eeprom_read_station_info(uint8_t station_id[STATION_ID_BYTES],
                               uint8_t station_key[STATION_KEY_BYTES])
 {
   eeprom_read_station_id(station_id);
-  eeprom_read_block(station_key, stats.station_key, sizeof(stats.station_key));
+  __read_block(station_key, stats.station_key, sizeof(stats.station_key));
 }
 
 void eeprom_read_station_id(uint8_t station_id[STATION_ID_BYTES])
 {
-  eeprom_read_block(station_id, stats.station_id, sizeof(stats.station_id));
+  __read_block(station_id, stats.station_id, sizeof(stats.station_id));
+}
+
+static uint8_t __slot_check(uint32_t value)
+{
+  uint8_t *bytes = (uint8_t *)&value;
+
+  return CONFIG_MARKER ^ bytes[0] ^ bytes[1] ^ bytes[2] ^ bytes[3];
+}
+
+/*
+ * Queues the next ring slot with a value COUNTER_LEASE ahead.
+ */
+static void __reserve_counter(void)
+{
+  counter_slot_t slot;
+
+  slot.value = counter + COUNTER_LEASE;
+  slot.check = __slot_check(slot.value);
+  __write(&stats.counter_ring[counter_next_slot], &slot, sizeof(slot));
+  counter_next_slot = (counter_next_slot + 1) % COUNTER_SLOTS;
+  counter_reserved = slot.value;
 }
 
+/*
+ * Finds the highest valid slot of the counter ring. Everything up to it
+ * may have been handed out before the last reset, so counting resumes
+ * there. A write torn by power loss leaves an invalid slot or one no
+ * higher than the reservation that was being written, so the counter
+ * never goes back.
+ */
+void eeprom_load_counter(void)
+{
+  counter_slot_t slot;
+  uint8_t i;
+
+  counter = __read_dword(&stats.counter);
+  if (counter == 0xffffffff) {
+    counter = 0;
+  }
+  counter_next_slot = 0;
+  for (i = 0; i < COUNTER_SLOTS; i++) {
+    eeprom_read_block(&slot, &stats.counter_ring[i], sizeof(slot));
+    if (slot.check == __slot_check(slot.value) && slot.value >= counter) {
+      counter = slot.value;
+      counter_next_slot = (i + 1) % COUNTER_SLOTS;
+    }
+  }
+  counter_reserved = counter_durable = counter;
+  counter_loaded = true;
+  __reserve_counter();
+}
+
+/*
+ * Hands out the next counter value from RAM. The reservation in EEPROM is
+ * renewed in the background well before it runs out; only if it has not
+ * been programmed in time does this wait for it.
+ */
 void eeprom_increment_counter(uint32_t *ctr)
 {
-  *ctr = increment_eeprom_uint32(&stats.counter);
+  if (!counter_loaded) {
+    eeprom_load_counter();
+  }
+  if (!eeprom_queue_pending()) {
+    counter_durable = counter_reserved;
+  }
+  if (counter == counter_durable) {
+    if (counter_reserved == counter_durable) {
+      __reserve_counter();
+    }
+    eeprom_queue_flush();
+    counter_durable = counter_reserved;
+  }
+  *ctr = ++counter;
+  if (counter_reserved == counter_durable &&
+      counter_durable - counter < COUNTER_LEASE / 2) {
+    __reserve_counter();
+  }
+}
+
+uint32_t eeprom_read_counter(void)
+{
+  if (!counter_loaded) {
+    eeprom_load_counter();
+  }
+  return counter;
+}
+
+static uint32_t *__mirrored_address(uint8_t i)
+{
+  switch (i) {
+  case MIRROR_USART_FAIL:
+    return &stats.number_usart_fail;
+  case MIRROR_PORF:
+    return &stats.number_porf;
+  case MIRROR_EXTRF:
+    return &stats.number_extrf;
+  case MIRROR_BORF:
+    return &stats.number_borf;
+  default:
+    return &stats.number_wdrf;
+  }
+}
+
+/*
+ * Reads the reset and failure counters into RAM. They are read
+ * on every URL but change rarely. Done on first use; not possible in
+ * reset_mcusr() as .bss is cleared after it.
+ */
+void eeprom_load_stats(void)
+{
+  uint8_t i;
+
+  eeprom_queue_flush();
+  for (i = 0; i < NUM_MIRRORED; i++) {
+    mirror[i] = eeprom_read_dword(__mirrored_address(i));
+  }
+  mirror_dirty = 0;
+  mirror_loaded = true;
+  mirror_changed = true;
+}
+
+static uint32_t __read_mirrored(uint8_t i)
+{
+  if (!mirror_loaded) {
+    eeprom_load_stats();
+  }
+  return mirror[i];
+}
+
+static void __increment_mirrored(uint8_t i)
+{
+  if (!mirror_loaded) {
+    eeprom_load_stats();
+  }
+  mirror[i]++;
+  mirror_dirty |= 1 << i;
+}
+
+/*
+ * Queues the counters changed since the last write-back. Bytes that did
+ * not change are skipped by the queue.
+ */
+void eeprom_write_back_stats(void)
+{
+  uint8_t i;
+
+  for (i = 0; mirror_dirty != 0; i++) {
+    if (mirror_dirty & (1 << i)) {
+      __write(__mirrored_address(i), &mirror[i], sizeof(mirror[i]));
+      mirror_dirty &= ~(1 << i);
+    }
+  }
+}
+
+bool eeprom_stats_changed(void)
+{
+  return mirror_changed;
+}
+
+void eeprom_clear_stats_changed(void)
+{
+  mirror_changed = false;
 }
 
 void eeprom_increment_usart_fail(void)
 {
-  (void)increment_eeprom_uint32(&stats.number_usart_fail);
+  __increment_mirrored(MIRROR_USART_FAIL);
+  mirror_changed = true;
 }
 
 uint32_t eeprom_read_number_porf(void)
 {
-  return eeprom_read_dword(&stats.number_porf);
+  return __read_mirrored(MIRROR_PORF);
 }
 
 uint32_t eeprom_read_number_borf(void)
 {
-  return eeprom_read_dword(&stats.number_borf);
+  return __read_mirrored(MIRROR_BORF);
 }
 
 uint32_t eeprom_read_number_extrf(void)
 {
-  return eeprom_read_dword(&stats.number_extrf);
+  return __read_mirrored(MIRROR_EXTRF);
 }
 
 uint32_t eeprom_read_number_wdrf(void)
 {
-  return eeprom_read_dword(&stats.number_wdrf);
+  return __read_mirrored(MIRROR_WDRF);
 }
 
 uint32_t eeprom_read_number_usart_fail(void)
 {
-  return eeprom_read_dword(&stats.number_usart_fail);
+  return __read_mirrored(MIRROR_USART_FAIL);
+}
+
+static uint8_t __touch_weights_check(const uint8_t weights[])
+{
+  uint8_t check = CONFIG_MARKER;
+  uint8_t i;
+
+  for (i = 0; i < NUM_TOUCH_KINDS; i++) {
+    check ^= weights[i];
+  }
+  return check;
+}
+
+/*
+ * Stations provisioned before the weights existed, or whose write was
+ * torn, start over with no touches.
+ */
+void eeprom_read_touch_weights(uint8_t weights[])
+{
+  uint8_t i;
+
+  for (i = 0; i < NUM_TOUCH_KINDS; i++) {
+    weights[i] = __read_byte(&stats.touch_weights[i]);
+  }
+  if (__read_byte(&stats.touch_weights_check) !=
+      __touch_weights_check(weights)) {
+    memset(weights, 0, NUM_TOUCH_KINDS);
+  }
+}
+
+void eeprom_write_touch_weights(const uint8_t weights[])
+{
+  uint8_t check = __touch_weights_check(weights);
+
+  __write(stats.touch_weights, weights, NUM_TOUCH_KINDS);
+  __write(&stats.touch_weights_check, &check, sizeof(check));
 }
 
 void eeprom_set_flag(uint8_t bit)
 {
  uint8_t flags;
- flags = eeprom_read_byte(&stats.flags);
+ flags = __read_byte(&stats.flags);
  flags |= 1 << bit;
  eeprom_write_byte(&stats.flags, flags);
 }
@@ -187,12 +464,17 @@ void eeprom_set_flag(uint8_t bit)
 void eeprom_clear_flag(uint8_t bit)
 {
  uint8_t flags;
- flags = eeprom_read_byte(&stats.flags);
+ flags = __read_byte(&stats.flags);
  flags &= ~(1 << bit);
  eeprom_write_byte(&stats.flags, flags);
 }
 
 bool eeprom_is_flag_set(uint8_t bit)
 {
-  return (eeprom_read_byte(&stats.flags) & (1 << bit)) != 0;
+  return (__read_byte(&stats.flags) & (1 << bit)) != 0;
+}
+
+void eeprom_write_trace(uint8_t offset, uint8_t value)
+{
+  eeprom_queue_write(&stats.trace[offset], &value, 1);
 }
@@ -30,6 +30,20 @@
 
 #define FLAG_FORCED_WDT 0
 
+// Slots of the wear-leveled station counter ring
+#ifndef COUNTER_SLOTS
+#define COUNTER_SLOTS 16
+#endif
+
+// Counter values reserved in EEPROM ahead of use. Up to this many values
+// are skipped after a reset.
+#ifndef COUNTER_LEASE
+#define COUNTER_LEASE 8
+#endif
+
+// Bytes reserved for the trace dump, see trace.h
+#define TRACE_PAGE_BYTES 128
+
 // Increases counters based on reset status flags.
 void eeprom_count_mcusr(uint8_t mcusr);
 
@@ -43,9 +57,26 @@ void eeprom_read_station_info(uint8_t station_id[STATION_ID_BYTES],
                               uint8_t station_key[STATION_KEY_BYTES]);
 void eeprom_read_station_id(uint8_t station_id[STATION_ID_BYTES]);
 
-// Increment a 32bit counter stored in EEPROM.
+// Reads the station counter from EEPROM into RAM. Done on first use.
+void eeprom_load_counter(void);
+
+// Increment the 32bit station counter. Does not wait for EEPROM.
 void eeprom_increment_counter(uint32_t *ctr);
 
+// Return the counter without incrementing it.
+uint32_t eeprom_read_counter(void);
+
+// Reads the counters below into RAM. Done on first use.
+void eeprom_load_stats(void);
+
+// Queues counters changed in RAM for writing to EEPROM.
+void eeprom_write_back_stats(void);
+
+// Set whenever one of the reset or failure counters changes, until
+// cleared by their one reader, the URL builder.
+bool eeprom_stats_changed(void);
+void eeprom_clear_stats_changed(void);
+
 // Increment counter for serial (USART) failures
 void eeprom_increment_usart_fail(void);
 
@@ -64,8 +95,18 @@ uint32_t eeprom_read_number_wdrf(void);
 // Return number of serial (USART) failures / timeout
 uint32_t eeprom_read_number_usart_fail(void);
 
+// Read the touch weights of poll_schedule.c, NUM_TOUCH_KINDS bytes.
+// All zero if never written.
+void eeprom_read_touch_weights(uint8_t weights[]);
+
+// Queue the touch weights for writing. Unchanged bytes are skipped.
+void eeprom_write_touch_weights(const uint8_t weights[]);
+
 void eeprom_set_flag(uint8_t bit);
 void eeprom_clear_flag(uint8_t bit);
 bool eeprom_is_flag_set(uint8_t bit);
 
+// Queues byte offset of the trace page for writing. Not traced.
+void eeprom_write_trace(uint8_t offset, uint8_t value);
+
 #endif /* !__EEPROM_DATA_H__ */
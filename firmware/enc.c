@@ -24,41 +24,97 @@
 
 #include "enc.h"
 
+// Expanded key schedule, computed once by enc_set_key.
+static aes128_ctx_t __ctx;
+
+// Expanded MAC key schedule, see enc_set_mac_key.
+static aes128_ctx_t __mac_ctx;
+
+// CMAC subkeys K1 and K2, derived from the MAC key.
+static uint8_t __cmac_k1[BLOCK_SIZE];
+static uint8_t __cmac_k2[BLOCK_SIZE];
+
 /*
- * Encode a 128bit buffer with the key.
+ * Multiply a 128 bit value by x in GF(2^128), as used for the CMAC
+ * subkeys. out and in may be the same buffer.
  */
-void enc128(uint8_t buffer[], uint8_t key[])
+static void __cmac_double(uint8_t out[], uint8_t in[])
 {
-  aes128_ctx_t ctx;
+  uint8_t carry = 0;
+  int8_t i;
+
+  for (i = BLOCK_SIZE - 1; i >= 0; i--) {
+    uint8_t b = in[i];
+    out[i] = (b << 1) | carry;
+    carry = b >> 7;
+  }
+  if (carry) {
+    out[BLOCK_SIZE - 1] ^= 0x87;
+  }
+}
+
+/*
+ * Expand the key used by mac64 and derive the CMAC subkeys.
+ */
+void enc_set_mac_key(uint8_t key[])
+{
+  aes128_init(key, &__mac_ctx);
+
+  memset(__cmac_k1, 0, sizeof(__cmac_k1));
+  aes128_enc(__cmac_k1, &__mac_ctx);
+  __cmac_double(__cmac_k1, __cmac_k1);
+  __cmac_double(__cmac_k2, __cmac_k1);
+}
+
+/*
+ * Expand the key used by enc128 and enc128_ctr, and set the MAC key to
+ * the key encrypted with an all ones block. CMAC must not share the key
+ * with CTR: with a zero felica id the first CMAC block equals the first
+ * CTR counter block, and the URL would give away its encryption. No
+ * counter block is all ones, as the middle of it is always zero. Key
+ * expansion is as expensive as encrypting several blocks, so it is done
+ * only when the key changes.
+ */
+void enc_set_key(uint8_t key[])
+{
+  uint8_t mac_key[BLOCK_SIZE];
+
+  aes128_init(key, &__ctx);
+
+  memset(mac_key, 0xff, sizeof(mac_key));
+  aes128_enc(mac_key, &__ctx);
+  enc_set_mac_key(mac_key);
+  memset(mac_key, 0, sizeof(mac_key));
+}
 
-  aes128_init(key, &ctx);
-  aes128_enc(buffer, &ctx);
+/*
+ * Encode a 128bit buffer with the key set by enc_set_key.
+ */
+void enc128(uint8_t buffer[])
+{
+  aes128_enc(buffer, &__ctx);
 }
 
 /*
- * Encode a buffer by 128 bit blocks, using CTR (Counter) method.
+ * Encode a buffer by 128 bit blocks, using CTR (Counter) method with the
+ * key set by enc_set_key.
  *
  * Arguments:
  * buffer: Plain text to be encrypted. Overwritten with cipher text.
  * buffer_length: Length of buffer in bytes.
- * key: Encryption key.
  * counter: 128 bit counter for encryption. Modified by this method.
  */
-void enc128_ctr(uint8_t buffer[], uint8_t buffer_length,
-                uint8_t key[], uint8_t counter[])
+void enc128_ctr(uint8_t buffer[], uint8_t buffer_length, uint8_t counter[])
 {
   uint8_t tmp[16];
 
-  aes128_ctx_t ctx;
-  aes128_init(key, &ctx);
-
   for (int i = 0; i < buffer_length; i += BLOCK_SIZE) {
     uint8_t *block = &buffer[i];
     uint8_t remain = buffer_length - i;
     uint8_t j, count;
 
     memcpy(tmp, counter, sizeof(tmp));
-    aes128_enc(tmp, &ctx);
+    aes128_enc(tmp, &__ctx);
     count = (remain < BLOCK_SIZE) ? remain : BLOCK_SIZE;
     for (j = 0; j < count; j++) {
       block[j] ^= tmp[j];
@@ -68,6 +124,43 @@ void enc128_ctr(uint8_t buffer[], uint8_t buffer_length,
   }
 }
 
+/*
+ * Compute a 64bit message authentication code from a byte buffer: the
+ * first 64 bits of AES-CMAC (RFC 4493) with the MAC key.
+ */
+void mac64(uint8_t result64[], uint8_t buffer[], uint8_t size)
+{
+  uint8_t mac[BLOCK_SIZE];
+  uint8_t *subkey = __cmac_k1;
+  uint8_t i = 0;
+  uint8_t j, remain;
+
+  memset(mac, 0, sizeof(mac));
+  /* CBC over all blocks but the last */
+  for (; size - i > BLOCK_SIZE; i += BLOCK_SIZE) {
+    for (j = 0; j < BLOCK_SIZE; j++) {
+      mac[j] ^= buffer[i + j];
+    }
+    aes128_enc(mac, &__mac_ctx);
+  }
+
+  /* last block: K1 if complete, else padded with 10...0 and K2 */
+  remain = size - i;
+  for (j = 0; j < remain; j++) {
+    mac[j] ^= buffer[i + j];
+  }
+  if (remain < BLOCK_SIZE) {
+    mac[remain] ^= 0x80;
+    subkey = __cmac_k2;
+  }
+  for (j = 0; j < BLOCK_SIZE; j++) {
+    mac[j] ^= subkey[j];
+  }
+  aes128_enc(mac, &__mac_ctx);
+
+  memcpy(result64, mac, HASH_SIZE);
+}
+
 /*
  * Compute a 64bit hash from a byte buffer.
  */
@@ -75,6 +168,14 @@ void hash64(uint8_t result64[], uint8_t buffer[], uint8_t size)
 {
   sha1_hash_t dest;
 
+#ifdef WITH_SHA1_ASM
+  if (size <= SHA1_SHORT_MAX) {
+    sha1_short(dest, buffer, size);
+  } else {
+    sha1(dest, buffer, size);
+  }
+#else
   sha1(dest, buffer, size);
+#endif
   memcpy(result64, dest, HASH_SIZE);
 }
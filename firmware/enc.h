@@ -24,12 +24,21 @@
 #define BLOCK_SIZE 16 /* bytes */
 #define HASH_SIZE 8 /* bytes */
 
+// Expand the key for enc128, enc128_ctr and mac64. Call when it changes.
+// mac64 uses a key derived from it.
+void enc_set_key(uint8_t key[]);
+
+// Expand a key for mac64 alone. enc_set_key sets the derived one.
+void enc_set_mac_key(uint8_t key[]);
+
 // Encrypt 128 bit buffer with the key.
-void enc128(uint8_t buffer[], uint8_t key[]);
+void enc128(uint8_t buffer[]);
 
 // Encode a buffer by 16 byte blocks, using CTR (Counter) method
-void enc128_ctr(uint8_t buffer[], uint8_t buffer_length,
-                uint8_t key[], uint8_t counter[]);
+void enc128_ctr(uint8_t buffer[], uint8_t buffer_length, uint8_t counter[]);
+
+// Compute a 64bit AES-CMAC from a byte buffer with the MAC key.
+void mac64(uint8_t result64[], uint8_t buffer[], uint8_t size);
 
 // Compute a 64bit hash from a byte buffer.
 void hash64(uint8_t result64[], uint8_t buffer[], uint8_t size);
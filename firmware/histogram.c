@@ -0,0 +1,53 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Latency histograms of touches, see histogram.h.
+ */
+
+#include "histogram.h"
+
+static uint8_t counts[NUM_HISTOGRAMS][HISTOGRAM_BUCKETS];
+
+static uint8_t __bucket(uint16_t ms)
+{
+  uint8_t bucket = 0;
+
+  ms /= HISTOGRAM_FIRST_MS;
+  while (ms > 0 && bucket < HISTOGRAM_BUCKETS - 1) {
+    ms >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void histogram_add(uint8_t hist, uint16_t ms)
+{
+  counts[hist][__bucket(ms)]++;
+}
+
+const uint8_t *histogram_counts(uint8_t hist)
+{
+  return counts[hist];
+}
+
+uint8_t histogram_length(uint8_t hist)
+{
+  uint8_t length = HISTOGRAM_BUCKETS;
+
+  while (length > 0 && counts[hist][length - 1] == 0) {
+    length--;
+  }
+  return length;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Latency histograms of touches, sent to the server in the URL (see
+ * proto/base_station.proto). Buckets double in width: bucket b counts
+ * times below HISTOGRAM_FIRST_MS << b, the last one all longer times.
+ * Counts live in RAM, start at 0 on reset and wrap at 256; the server
+ * takes differences between reports of a station.
+ */
+
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+#include <stdint.h>
+
+#define HISTOGRAM_BUCKETS 8
+#define HISTOGRAM_FIRST_MS 16
+
+enum histogram {
+  HIST_TOUCH_TO_PUSH,   // phone seen until the URL is delivered
+  HIST_POLL_TO_DETECT,  // Felica poll started until a phone answered
+  HIST_LLCP_SESSION,    // LLCP exchange of a completed SNEP/NPP push
+  NUM_HISTOGRAMS
+};
+
+// Counts a time of ms in histogram hist.
+void histogram_add(uint8_t hist, uint16_t ms);
+
+// Returns the HISTOGRAM_BUCKETS counts of hist.
+const uint8_t *histogram_counts(uint8_t hist);
+
+// Returns the number of buckets up to the last non-zero one, 0 if all
+// are zero.
+uint8_t histogram_length(uint8_t hist);
+
+#endif /* !__HISTOGRAM_H__ */
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Host replacement for <avr/eeprom.h>, backed by host/eeprom.c.
+ */
+
+#ifndef __HOST_AVR_EEPROM_H__
+#define __HOST_AVR_EEPROM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define EEMEM __attribute__((section(".eeprom")))
+
+/* Last EEPROM address of the ATmega328P */
+#define E2END 0x3ff
+
+uint8_t eeprom_read_byte(const uint8_t *addr);
+uint32_t eeprom_read_dword(const uint32_t *addr);
+void eeprom_read_block(void *dst, const void *src, size_t n);
+
+void eeprom_write_byte(uint8_t *addr, uint8_t value);
+void eeprom_write_dword(uint32_t *addr, uint32_t value);
+void eeprom_write_block(const void *src, void *dst, size_t n);
+
+#endif /* __HOST_AVR_EEPROM_H__ */
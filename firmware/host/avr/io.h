@@ -0,0 +1,60 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Host replacement for <avr/io.h>. I/O registers are plain variables so
+ * that code touching ports still compiles and links on Linux. Only the
+ * registers and bits used by the host-built modules are declared.
+ */
+
+#ifndef __HOST_AVR_IO_H__
+#define __HOST_AVR_IO_H__
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+
+extern volatile uint8_t DDRB, PORTB, PINB;
+extern volatile uint8_t DDRC, PORTC, PINC;
+extern volatile uint8_t DDRD, PORTD, PIND;
+extern volatile uint8_t MCUSR;
+extern volatile uint8_t SREG;
+extern volatile uint16_t EEAR;
+
+/* MCUSR bits */
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+
+/* Port bits */
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PORTB0 0
+#define PORTC4 4
+#define PORTC5 5
+#define PD3 3
+#define PD5 5
+#define PD7 7
+#define PORTD0 0
+#define PORTD1 1
+#define PORTD6 6
+
+#endif /* __HOST_AVR_IO_H__ */
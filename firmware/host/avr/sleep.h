@@ -0,0 +1,35 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Host replacement for <avr/sleep.h>. Sleeping yields the CPU briefly,
+ * which is close enough for loops that sleep until an interrupt arrives.
+ */
+
+#ifndef __HOST_AVR_SLEEP_H__
+#define __HOST_AVR_SLEEP_H__
+
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_PWR_DOWN 1
+#define SLEEP_MODE_PWR_SAVE 2
+
+#define set_sleep_mode(mode) ((void)(mode))
+#define sleep_mode() host_yield()
+#define sleep_enable() ((void)0)
+#define sleep_cpu() host_yield()
+#define sleep_disable() ((void)0)
+
+void host_yield(void);
+
+#endif /* __HOST_AVR_SLEEP_H__ */
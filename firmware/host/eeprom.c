@@ -0,0 +1,72 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Host version of the avr-libc EEPROM routines on a simulated 1 KiB
+ * EEPROM. Small integer addresses (as used by the tests) index the
+ * simulated array. Anything else is a variable placed in the .eeprom
+ * section, which on the host is ordinary writable memory.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <avr/eeprom.h>
+
+#include "host.h"
+
+static uint8_t __eeprom[E2END + 1] = { [0 ... E2END] = 0xff };
+
+static uint8_t *__cell(const void *addr)
+{
+  uintptr_t a = (uintptr_t)addr;
+  return (a <= E2END) ? &__eeprom[a] : (uint8_t *)addr;
+}
+
+void eeprom_host_erase(void)
+{
+  memset(__eeprom, 0xff, sizeof(__eeprom));
+}
+
+uint8_t eeprom_read_byte(const uint8_t *addr)
+{
+  return *__cell(addr);
+}
+
+uint32_t eeprom_read_dword(const uint32_t *addr)
+{
+  uint32_t value;
+  eeprom_read_block(&value, addr, sizeof(value));
+  return value;
+}
+
+void eeprom_read_block(void *dst, const void *src, size_t n)
+{
+  memcpy(dst, __cell(src), n);
+}
+
+void eeprom_write_byte(uint8_t *addr, uint8_t value)
+{
+  *__cell(addr) = value;
+}
+
+void eeprom_write_dword(uint32_t *addr, uint32_t value)
+{
+  eeprom_write_block(&value, addr, sizeof(value));
+}
+
+void eeprom_write_block(const void *src, void *dst, size_t n)
+{
+  memcpy(__cell(dst), src, n);
+}
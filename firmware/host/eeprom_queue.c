@@ -0,0 +1,101 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Host version of peripheral/eeprom_queue.c. Writes complete at once
+ * unless a test defers them to simulate programming time and power loss.
+ */
+
+#include <stdlib.h>
+
+#include <avr/eeprom.h>
+
+#include "peripheral/eeprom_queue.h"
+
+#include "host.h"
+
+static uint8_t *__queue_addr[EEPROM_QUEUE_SIZE];
+static uint8_t __queue_data[EEPROM_QUEUE_SIZE];
+static uint8_t __queue_length;
+static bool __queue_defer;
+
+/*
+ * Programs the oldest queued byte.
+ */
+static void __program(void)
+{
+  uint8_t i;
+
+  eeprom_write_byte(__queue_addr[0], __queue_data[0]);
+  for (i = 1; i < __queue_length; i++) {
+    __queue_addr[i - 1] = __queue_addr[i];
+    __queue_data[i - 1] = __queue_data[i];
+  }
+  __queue_length--;
+}
+
+void eeprom_queue_init(void)
+{
+  __queue_length = 0;
+}
+
+void eeprom_queue_write(void *dst, const void *src, uint8_t len)
+{
+  uint8_t *to = dst;
+  const uint8_t *from = src;
+
+  while (len--) {
+    if (__queue_length == EEPROM_QUEUE_SIZE) {
+      __program();
+    }
+    __queue_addr[__queue_length] = to++;
+    __queue_data[__queue_length] = *from++;
+    __queue_length++;
+  }
+  if (!__queue_defer) {
+    eeprom_queue_flush();
+  }
+}
+
+bool eeprom_queue_pending(void)
+{
+  return __queue_length > 0;
+}
+
+void eeprom_queue_flush(void)
+{
+  while (__queue_length > 0) {
+    __program();
+  }
+}
+
+void eeprom_host_defer_writes(bool defer)
+{
+  __queue_defer = defer;
+  if (!defer) {
+    eeprom_queue_flush();
+  }
+}
+
+void eeprom_host_power_loss(uint8_t written, bool torn)
+{
+  while (written-- && __queue_length > 0) {
+    __program();
+  }
+  if (torn && __queue_length > 0) {
+    // Erased, then only partly programmed
+    eeprom_write_byte(__queue_addr[0], __queue_data[0] | (uint8_t)rand());
+  }
+  __queue_length = 0;
+}
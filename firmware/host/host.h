@@ -0,0 +1,46 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Hooks into the host shims that have no counterpart on the AVR.
+ */
+
+#ifndef __HOST_H__
+#define __HOST_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Environment variable naming the serial device that replaces the USART.
+#define HOST_USART_ENV "RCS956_TTY"
+
+// Opens a serial device (tty or pseudo-terminal) as the USART.
+bool usart_host_open(const char *path);
+
+// Waits up to the given time for received data. True if data is ready.
+bool usart_host_wait(uint16_t ms);
+
+// Resets the simulated EEPROM to its erased state (all 0xff).
+void eeprom_host_erase(void);
+
+// Keeps queued EEPROM writes pending until flushed, as if the AVR was
+// still programming them. Off by default: queued writes complete at once.
+void eeprom_host_defer_writes(bool defer);
+
+// Simulates power loss while queued EEPROM writes are programmed: the
+// first bytes complete, the next one is torn if requested, the rest are
+// lost.
+void eeprom_host_power_loss(uint8_t written, bool torn);
+
+#endif /* __HOST_H__ */
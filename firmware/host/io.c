@@ -0,0 +1,46 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Host stand-ins for the AVR I/O registers and busy-wait delays.
+ */
+
+#include <time.h>
+
+#include <avr/io.h>
+#include <util/delay.h>
+
+volatile uint8_t DDRB, PORTB, PINB;
+volatile uint8_t DDRC, PORTC, PINC;
+volatile uint8_t DDRD, PORTD, PIND;
+volatile uint8_t MCUSR;
+volatile uint8_t SREG;
+volatile uint16_t EEAR;
+
+/*
+ * Sleeps for at least the given number of microseconds.
+ */
+void _delay_us(double us)
+{
+  struct timespec ts;
+
+  ts.tv_sec = (time_t)(us / 1000000);
+  ts.tv_nsec = (long)((us - ts.tv_sec * 1000000.0) * 1000);
+  while (nanosleep(&ts, &ts) != 0) {};
+}
+
+void _delay_ms(double ms)
+{
+  _delay_us(ms * 1000);
+}
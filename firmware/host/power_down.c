@@ -0,0 +1,80 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Host version of peripheral/power_down.c. Sleeping waits for the same
+ * wall clock time the AVR would sleep. Idle mode wakes up early when
+ * the USART receives data, as the RX interrupt does on the AVR.
+ */
+
+#include <poll.h>
+#include <stddef.h>
+#include <unistd.h>
+
+#include <avr/sleep.h>
+
+#include "peripheral/power_down.h"
+
+#include "host.h"
+
+void disable_unused_circuits()
+{
+}
+
+void sleep_until_timer(uint8_t mode, bool clock_down)
+{
+  uint16_t ms = 1024L * 255 * 1000 / F_CPU;
+
+  if (clock_down) {
+    ms *= 8;
+  }
+  if (mode == SLEEP_MODE_IDLE) {
+    (void)usart_host_wait(ms);
+  } else {
+    poll(NULL, 0, ms);
+  }
+}
+
+void sleep_forever()
+{
+  for (;;) {
+    pause();
+  }
+}
+
+bool sleep_forever_unless(bool (*awake)(void))
+{
+  if (awake != NULL && awake()) {
+    return false;
+  }
+  sleep_forever();
+  return true;
+}
+
+void host_yield(void)
+{
+  (void)usart_host_wait(1);
+}
+
+void wakeup_on_external_interrupt(void)
+{
+}
+
+void reset_on_power_change(void)
+{
+}
+
+void disable_reset_on_power_change(void)
+{
+}
@@ -0,0 +1,656 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Simulated RC-S956 module. Runs in its own thread on the master side
+ * of a pseudo-terminal; the station opens the slave side as its USART.
+ *
+ * Command flow, as seen from the module:
+ *   <- 00 00 ff LEN LCS d4 CMD ... DCS 00  command from the host
+ *   -> 00 00 ff 00 ff 00                    ACK after ack_us
+ *   -> 00 00 ff LEN LCS d5 CMD+1 ... DCS 00 response after latency + RF
+ * An ACK from the host cancels the pending response.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rcs956_sim.h"
+
+// RC-S956 command codes handled with more than an empty response
+#define WRITE_REGISTER 0x08
+#define RESET 0x18
+#define LIST_TGT 0x4a
+#define IN_RELEASE 0x52
+#define TG_GET_DEP_DATA 0x86
+#define TG_INIT 0x8c
+#define TG_SET_DEP_DATA 0x8e
+#define TG_SET_GENERAL_BYTES 0x92
+#define COMM_THRU_EX 0xa0
+
+// LLCP PDU types and SAPs used by the simulated phone
+#define PDU_SYMM 0x00
+#define PDU_CONNECT 0x04
+#define PDU_DISC 0x05
+#define PDU_CC 0x06
+#define PDU_DM 0x07
+#define PDU_I 0x0c
+#define PHONE_SAP 0x04  // SNEP
+#define STATION_SAP 0x20
+
+// Felica commands
+#define FELICA_POLL 0x00
+#define FELICA_POLL_RES 0x01
+#define FELICA_CHECK 0x06
+#define FELICA_CHECK_RES 0x07
+
+#define FRAME_SIZE (255 + 7)
+
+enum frame_state { SYNC, LENGTH, LENGTH_CHECK, DATA, DATA_CHECK, POSTAMBLE };
+
+static const uint8_t phone_idm[8] = {
+  0x01, 0x2e, 0x3c, 0x4d, 0x5e, 0x6f, 0x70, 0x81
+};
+static const uint8_t phone_pmm[8] = {
+  0x03, 0x01, 0x4b, 0x02, 0x4f, 0x49, 0x93, 0xff
+};
+
+static struct {
+  struct rcs956_sim_config config;
+  pthread_mutex_t lock;
+  int fd;
+
+  // Frame parser
+  enum frame_state state;
+  uint8_t prev;
+  uint8_t len;
+  uint8_t pos;
+  uint8_t data[256];
+
+  // Response scheduled for later
+  bool pending;
+  struct timespec due;
+  uint8_t resp[256];
+  uint8_t resp_len;
+  bool resp_touch;  // sending the response starts a touch
+
+  // Conversation with the phone
+  bool target_mode;
+  uint8_t last_pdu;       // LLCP PDU type last sent by the station
+  uint8_t card_idm[8];    // Type 3 IDm reported by the station
+  uint16_t next_block;    // Type 3 block to request next, 0 = attribute
+  uint16_t num_blocks;
+  uint8_t max_check;      // nbr from the attribute block
+  uint8_t check_blocks;   // blocks requested by the last check
+
+  bool listening;
+  struct timespec listen_start;
+
+  bool touching;
+  struct timespec touch_start;
+  struct rcs956_sim_stats stats;
+} sim = {
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+  .fd = -1,
+};
+
+static int64_t __us_since(const struct timespec *t)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)(now.tv_sec - t->tv_sec) * 1000000
+      + (now.tv_nsec - t->tv_nsec) / 1000;
+}
+
+static void __write_all(const uint8_t *buf, size_t len)
+{
+  ssize_t n;
+
+  while (len > 0) {
+    n = write(sim.fd, buf, len);
+    if (n > 0) {
+      buf += n;
+      len -= n;
+    } else if (n < 0 && errno != EAGAIN && errno != EINTR) {
+      return;
+    }
+  }
+}
+
+static void __send_ack(void)
+{
+  static const uint8_t ack[] = {0x00, 0x00, 0xff, 0x00, 0xff, 0x00};
+
+  if (sim.config.ack_us)
+    usleep(sim.config.ack_us);
+  __write_all(ack, sizeof(ack));
+}
+
+static void __send_frame(const uint8_t *data, uint8_t len)
+{
+  uint8_t frame[FRAME_SIZE];
+  uint8_t dcs = 0;
+  uint8_t i;
+
+  frame[0] = 0x00;
+  frame[1] = 0x00;
+  frame[2] = 0xff;
+  frame[3] = len;
+  frame[4] = 0x100 - len;
+  for (i = 0; i < len; i++) {
+    frame[5 + i] = data[i];
+    dcs += data[i];
+  }
+  frame[5 + len] = 0x100 - dcs;
+  frame[6 + len] = 0x00;
+  __write_all(frame, len + 7);
+}
+
+/*
+ * Records the end of a touch started by __start_touch.
+ */
+static void __end_touch(void)
+{
+  uint32_t us;
+
+  if (!sim.touching)
+    return;
+  sim.touching = false;
+  us = (uint32_t)__us_since(&sim.touch_start);
+  pthread_mutex_lock(&sim.lock);
+  if (sim.stats.touches == 0 || us < sim.stats.min_us)
+    sim.stats.min_us = us;
+  if (us > sim.stats.max_us)
+    sim.stats.max_us = us;
+  sim.stats.total_us += us;
+  sim.stats.touches++;
+  pthread_mutex_unlock(&sim.lock);
+}
+
+/*
+ * Starts counting the time a phone in the field would be found.
+ */
+static void __start_listen(void)
+{
+  sim.listening = true;
+  clock_gettime(CLOCK_MONOTONIC, &sim.listen_start);
+}
+
+static void __end_listen(void)
+{
+  if (!sim.listening)
+    return;
+  sim.listening = false;
+  pthread_mutex_lock(&sim.lock);
+  sim.stats.listen_us += __us_since(&sim.listen_start);
+  pthread_mutex_unlock(&sim.lock);
+}
+
+/*
+ * Schedules resp[0..resp_len) to be sent after the command latency
+ * plus rf_us.
+ */
+static void __schedule(uint8_t cmd, uint32_t rf_us, bool touch)
+{
+  uint64_t ns;
+
+  clock_gettime(CLOCK_MONOTONIC, &sim.due);
+  ns = sim.due.tv_nsec + ((uint64_t)sim.config.latency_us[cmd] + rf_us) * 1000;
+  sim.due.tv_sec += ns / 1000000000;
+  sim.due.tv_nsec = ns % 1000000000;
+  sim.resp_touch = touch;
+  sim.pending = true;
+}
+
+// Writes the phone's next Type 3 command after the status byte at resp[3].
+static uint8_t __type3_command(uint8_t *buf)
+{
+  uint8_t len = 0;
+  uint8_t count;
+  uint8_t i;
+
+  if (sim.next_block > sim.num_blocks && sim.num_blocks > 0) {
+    // All read: phone goes back to polling
+    buf[len++] = 6;
+    buf[len++] = FELICA_POLL;
+    buf[len++] = 0x12;
+    buf[len++] = 0xfc;
+    buf[len++] = 0x01;
+    buf[len++] = 0x00;
+    return len;
+  }
+  count = 1;
+  if (sim.next_block > 0) {
+    count = sim.num_blocks - sim.next_block + 1;
+    if (count > sim.max_check)
+      count = sim.max_check;
+  }
+  sim.check_blocks = count;
+  buf[len++] = 13 + 2 * count;
+  buf[len++] = FELICA_CHECK;
+  memcpy(&buf[len], sim.card_idm, 8);
+  len += 8;
+  buf[len++] = 1;     // one service
+  buf[len++] = 0x0b;  // NDEF service code
+  buf[len++] = 0x00;
+  buf[len++] = count;
+  for (i = 0; i < count; i++) {
+    buf[len++] = 0x80;
+    buf[len++] = sim.next_block + i;
+  }
+  return len;
+}
+
+/*
+ * Handles a Type 3 response from the station and prepares the next
+ * command of the simulated reader.
+ */
+static uint8_t __type3_exchange(const uint8_t *frame, uint8_t *buf)
+{
+  if (frame[1] == FELICA_POLL_RES) {
+    memcpy(sim.card_idm, &frame[2], 8);
+    sim.next_block = 0;
+    sim.num_blocks = 0;
+  } else if (frame[1] == FELICA_CHECK_RES && sim.next_block == 0) {
+    const uint8_t *attr = &frame[13];
+    uint32_t ln = ((uint32_t)attr[11] << 16) | (attr[12] << 8) | attr[13];
+
+    sim.max_check = attr[1] ? attr[1] : 1;
+    sim.num_blocks = (ln + 15) / 16;
+    sim.next_block = 1;
+  } else if (frame[1] == FELICA_CHECK_RES) {
+    sim.next_block += sim.check_blocks;
+    if (sim.next_block > sim.num_blocks)
+      __end_touch();
+  }
+  return __type3_command(buf);
+}
+
+// Writes the phone's next LLCP PDU, reacting to the station's last PDU.
+static uint8_t __llcp_pdu(uint8_t *buf)
+{
+  switch (sim.last_pdu) {
+    case PDU_CONNECT:
+      buf[0] = (STATION_SAP << 2) | (PDU_CC >> 2);
+      buf[1] = ((PDU_CC << 6) & 0xff) | PHONE_SAP;
+      return 2;
+    case PDU_I:
+      // SNEP success, acknowledging the PUT in the same PDU
+      buf[0] = (STATION_SAP << 2) | (PDU_I >> 2);
+      buf[1] = ((PDU_I << 6) & 0xff) | PHONE_SAP;
+      buf[2] = 0x01;
+      buf[3] = 0x10;
+      buf[4] = 0x81;
+      memset(&buf[5], 0, 4);
+      return 9;
+    case PDU_DISC:
+      buf[0] = (STATION_SAP << 2) | (PDU_DM >> 2);
+      buf[1] = ((PDU_DM << 6) & 0xff) | PHONE_SAP;
+      buf[2] = 0x00;
+      return 3;
+    default:
+      buf[0] = 0x00;
+      buf[1] = 0x00;
+      return 2;
+  }
+}
+
+/*
+ * Builds the activation reported by TgInitTarget for the phone in the
+ * field. Returns the response length, 0 if nobody activates the target.
+ */
+static uint8_t __activation(uint8_t *resp)
+{
+  static const uint8_t atr_req[] = {
+    30, 0xd4, 0x00,
+    0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,  // NFCID3
+    0x00, 0x00, 0x00, 0x32,  // DID BS BR PP
+    0x46, 0x66, 0x6d, 0x01, 0x01, 0x11, 0x03, 0x02, 0x00, 0x13,
+    0x04, 0x01, 0x96,
+  };
+  static const uint8_t poll[] = {6, FELICA_POLL, 0x12, 0xfc, 0x01, 0x00};
+
+  if (sim.config.phone == SIM_PHONE_LLCP) {
+    resp[2] = 0x05;  // 106kbps, DEP, active
+    memcpy(&resp[3], atr_req, sizeof(atr_req));
+    sim.last_pdu = PDU_SYMM;
+    return 3 + sizeof(atr_req);
+  } else if (sim.config.phone == SIM_PHONE_TYPE3) {
+    resp[2] = 0x12;  // 212kbps, Felica
+    memcpy(&resp[3], poll, sizeof(poll));
+    sim.next_block = 0;
+    sim.num_blocks = 0;
+    return 3 + sizeof(poll);
+  }
+  return 0;
+}
+
+/*
+ * Answers a command frame d4 CMD ... of length len.
+ */
+static void __handle_command(const uint8_t *cmd, uint8_t len)
+{
+  uint8_t *resp = sim.resp;
+  uint8_t code = cmd[1];
+  uint32_t rf_us = 0;
+  bool touch = false;
+  uint8_t n;
+
+  __end_listen();
+  __send_ack();
+
+  resp[0] = 0xd5;
+  resp[1] = code + 1;
+  resp[2] = 0x00;  // status, where the command has one
+  sim.resp_len = 3;
+
+  switch (code) {
+    case RESET:
+      sim.target_mode = false;
+      sim.resp_len = 2;
+      break;
+
+    case LIST_TGT:
+      sim.target_mode = false;
+      __start_listen();
+      if (sim.config.phone == SIM_PHONE_FELICA) {
+        resp[2] = 1;     // NbTg
+        resp[3] = 1;     // Tg
+        resp[4] = 0x12;  // polling response length
+        resp[5] = FELICA_POLL_RES;
+        memcpy(&resp[6], phone_idm, 8);
+        memcpy(&resp[14], phone_pmm, 8);
+        sim.resp_len = 22;
+        rf_us = sim.config.detect_us;
+        touch = true;
+      } else {
+        resp[2] = 0;
+        rf_us = sim.config.poll_us;
+      }
+      break;
+
+    case COMM_THRU_EX:
+      rf_us = sim.config.push_us;
+      if (sim.target_mode) {
+        n = __type3_exchange(&cmd[4], &resp[3]);
+        sim.resp_len = 3 + n;
+      } else if (sim.config.phone == SIM_PHONE_FELICA && len > 14) {
+        // Felica push response echoes the payload size
+        __end_touch();
+        resp[3] = 11;
+        resp[4] = 0xb1;
+        memcpy(&resp[5], phone_idm, 8);
+        resp[13] = cmd[14];
+        sim.resp_len = 14;
+      } else {
+        resp[2] = 0x01;  // RF timeout
+      }
+      break;
+
+    case IN_RELEASE:
+      sim.target_mode = false;
+      break;
+
+    case TG_INIT:
+      __start_listen();
+      n = __activation(resp);
+      if (n == 0) {
+        return;  // Wait until the host cancels
+      }
+      sim.target_mode = true;
+      sim.resp_len = n;
+      rf_us = sim.config.activate_us;
+      touch = true;
+      break;
+
+    case TG_GET_DEP_DATA:
+      rf_us = sim.config.dep_us;
+      sim.resp_len = 3 + __llcp_pdu(&resp[3]);
+      break;
+
+    case TG_SET_DEP_DATA:
+      if (len >= 4) {
+        sim.last_pdu = ((cmd[2] & 0x03) << 2) | (cmd[3] >> 6);
+        // I PDU with SNEP PUT: the record has been delivered
+        if (sim.last_pdu == PDU_I && len >= 7 && cmd[6] == 0x02)
+          __end_touch();
+      }
+      break;
+
+    default:
+      break;
+  }
+  __schedule(code, rf_us, touch);
+}
+
+static void __receive(uint8_t c)
+{
+  switch (sim.state) {
+    case SYNC:
+      if (sim.prev == 0x00 && c == 0xff)
+        sim.state = LENGTH;
+      break;
+    case LENGTH:
+      sim.len = c;
+      sim.state = LENGTH_CHECK;
+      break;
+    case LENGTH_CHECK:
+      if (sim.len == 0 && c == 0xff) {
+        // ACK from the host cancels the pending response
+        sim.pending = false;
+        __end_listen();
+        pthread_mutex_lock(&sim.lock);
+        sim.stats.cancels++;
+        pthread_mutex_unlock(&sim.lock);
+        sim.state = SYNC;
+      } else if ((uint8_t)(sim.len + c) != 0 || sim.len < 2) {
+        sim.state = SYNC;
+      } else {
+        sim.pos = 0;
+        sim.state = DATA;
+      }
+      break;
+    case DATA:
+      sim.data[sim.pos++] = c;
+      if (sim.pos == sim.len)
+        sim.state = DATA_CHECK;
+      break;
+    case DATA_CHECK: {
+      uint8_t sum = c;
+      uint8_t i;
+      for (i = 0; i < sim.len; i++)
+        sum += sim.data[i];
+      sim.state = (sum == 0) ? POSTAMBLE : SYNC;
+      break;
+    }
+    case POSTAMBLE:
+      sim.state = SYNC;
+      pthread_mutex_lock(&sim.lock);
+      sim.stats.frames++;
+      pthread_mutex_unlock(&sim.lock);
+      if (sim.data[0] == 0xd4)
+        __handle_command(sim.data, sim.len);
+      break;
+  }
+  sim.prev = c;
+}
+
+static void *__serve(void *arg)
+{
+  struct pollfd pfd;
+  uint8_t buf[64];
+  int64_t wait_us;
+  ssize_t n;
+  ssize_t i;
+
+  (void)arg;
+  pfd.fd = sim.fd;
+  pfd.events = POLLIN;
+  for (;;) {
+    int timeout = -1;
+
+    if (sim.pending) {
+      wait_us = -__us_since(&sim.due);
+      if (wait_us <= 0) {
+        sim.pending = false;
+        __end_listen();
+        __send_frame(sim.resp, sim.resp_len);
+        if (sim.resp_touch) {
+          sim.touching = true;
+          clock_gettime(CLOCK_MONOTONIC, &sim.touch_start);
+        }
+        continue;
+      }
+      timeout = (int)((wait_us + 999) / 1000);
+    }
+    if (poll(&pfd, 1, timeout) <= 0)
+      continue;
+    n = read(sim.fd, buf, sizeof(buf));
+    for (i = 0; i < n; i++)
+      __receive(buf[i]);
+  }
+  return NULL;
+}
+
+/*
+ * Default timing, loosely based on the RC-S620/S at 115200 bps and
+ * handsets seen in the field.
+ */
+void rcs956_sim_default_config(struct rcs956_sim_config *config)
+{
+  int i;
+
+  memset(config, 0, sizeof(*config));
+  config->phone = SIM_PHONE_FELICA;
+  for (i = 0; i < 256; i++)
+    config->latency_us[i] = 1000;
+  config->ack_us = 200;
+  config->detect_us = 5000;
+  config->poll_us = 100000;
+  config->push_us = 20000;
+  config->activate_us = 5000;
+  config->dep_us = 3000;
+}
+
+bool rcs956_sim_configure(struct rcs956_sim_config *config, const char *spec)
+{
+  static const struct {
+    const char *name;
+    size_t offset;
+  } params[] = {
+    {"ack", offsetof(struct rcs956_sim_config, ack_us)},
+    {"detect", offsetof(struct rcs956_sim_config, detect_us)},
+    {"poll", offsetof(struct rcs956_sim_config, poll_us)},
+    {"push", offsetof(struct rcs956_sim_config, push_us)},
+    {"activate", offsetof(struct rcs956_sim_config, activate_us)},
+    {"dep", offsetof(struct rcs956_sim_config, dep_us)},
+  };
+  const char *eq = strchr(spec, '=');
+  unsigned long us;
+  unsigned long code;
+  char *end;
+  size_t i;
+
+  if (eq == NULL)
+    return false;
+  us = strtoul(eq + 1, &end, 10);
+  if (*end != '\0' || end == eq + 1)
+    return false;
+  for (i = 0; i < sizeof(params) / sizeof(params[0]); i++) {
+    if (strlen(params[i].name) == (size_t)(eq - spec)
+        && strncmp(spec, params[i].name, eq - spec) == 0) {
+      *(uint32_t *)((char *)config + params[i].offset) = us;
+      return true;
+    }
+  }
+  code = strtoul(spec, &end, 16);
+  if (end != eq || code > 0xff)
+    return false;
+  config->latency_us[code] = us;
+  return true;
+}
+
+bool rcs956_sim_parse_phone(const char *name, enum rcs956_sim_phone *phone)
+{
+  static const char *names[] = {"none", "felica", "llcp", "type3"};
+  size_t i;
+
+  for (i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    if (strcmp(name, names[i]) == 0) {
+      *phone = (enum rcs956_sim_phone)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool rcs956_sim_start(const struct rcs956_sim_config *config,
+                      char *tty, size_t tty_size)
+{
+  struct termios tio;
+  pthread_t thread;
+  const char *name;
+  int slave;
+
+  sim.config = *config;
+  sim.fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (sim.fd < 0 || grantpt(sim.fd) != 0 || unlockpt(sim.fd) != 0)
+    return false;
+  name = ptsname(sim.fd);
+  if (name == NULL || strlen(name) >= tty_size)
+    return false;
+  strcpy(tty, name);
+
+  // Raw mode on the line; keep the slave open so the master never
+  // sees a hang-up while the station reconnects.
+  slave = open(name, O_RDWR | O_NOCTTY);
+  if (slave < 0)
+    return false;
+  if (tcgetattr(slave, &tio) == 0) {
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+  }
+  return pthread_create(&thread, NULL, __serve, NULL) == 0
+      && pthread_detach(thread) == 0;
+}
+
+void rcs956_sim_set_phone(enum rcs956_sim_phone phone)
+{
+  sim.config.phone = phone;
+}
+
+void rcs956_sim_get_stats(struct rcs956_sim_stats *stats)
+{
+  pthread_mutex_lock(&sim.lock);
+  *stats = sim.stats;
+  pthread_mutex_unlock(&sim.lock);
+}
+
+void rcs956_sim_reset_stats(void)
+{
+  pthread_mutex_lock(&sim.lock);
+  memset(&sim.stats, 0, sizeof(sim.stats));
+  pthread_mutex_unlock(&sim.lock);
+}
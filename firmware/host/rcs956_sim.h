@@ -0,0 +1,90 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Simulated RC-S620/S (RC-S956) module on a pseudo-terminal.
+ *
+ * Parses the normal frames sent by rcs956_send_command, ACKs them and
+ * answers with scripted responses after a configurable module latency
+ * plus RF time. A simulated phone can be a Felica handset (initiator
+ * mode push), an LLCP/SNEP device or a Type 3 tag reader (target mode).
+ *
+ * The simulator measures touch latency from its side of the wire:
+ * - initiator: InListPassiveTarget response to CommunicateThruEX push
+ * - target: activation (TgInitTarget response) to delivery of the NDEF
+ *   record (SNEP PUT or last Type 3 block)
+ * It also adds up the time the module listens for phones, from an
+ * InListPassiveTarget or TgInitTarget command to its response or cancel.
+ * The rest of the time the station is deaf to phones.
+ */
+
+#ifndef __RCS956_SIM_H__
+#define __RCS956_SIM_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum rcs956_sim_phone {
+  SIM_PHONE_NONE,    // Nothing in the field
+  SIM_PHONE_FELICA,  // Felica handset, receives a push as target
+  SIM_PHONE_LLCP,    // NFC-DEP initiator speaking LLCP/SNEP
+  SIM_PHONE_TYPE3,   // Felica reader that reads a Type 3 tag
+};
+
+struct rcs956_sim_config {
+  enum rcs956_sim_phone phone;
+  uint32_t latency_us[256];  // Module processing time per command code
+  uint32_t ack_us;           // Time until the ACK frame is sent
+  uint32_t detect_us;        // InListPassiveTarget RF time, phone present
+  uint32_t poll_us;          // InListPassiveTarget RF time, no phone
+  uint32_t push_us;          // RF time of one CommunicateThruEX exchange
+  uint32_t activate_us;      // Time until an initiator activates target
+  uint32_t dep_us;           // RF time of one DEP exchange
+};
+
+struct rcs956_sim_stats {
+  uint32_t frames;     // Command frames received
+  uint32_t cancels;    // ACK frames received (cancelled commands)
+  uint32_t touches;    // Completed touches
+  uint32_t min_us;     // Touch latency statistics
+  uint32_t max_us;
+  uint64_t total_us;
+  uint64_t listen_us;  // Time a phone could be found: polling as initiator
+                       // or waiting for activation as target
+};
+
+// Fills in default timing: 1ms per command plus typical RF times.
+void rcs956_sim_default_config(struct rcs956_sim_config *config);
+
+// Applies "name=us" (detect, poll, push, activate, dep, ack) or
+// "XX=us" (latency of command code XX in hex). Returns false if invalid.
+bool rcs956_sim_configure(struct rcs956_sim_config *config, const char *spec);
+
+// Parses a phone name (none, felica, llcp, type3). Returns false if unknown.
+bool rcs956_sim_parse_phone(const char *name, enum rcs956_sim_phone *phone);
+
+// Starts the simulator on a new pseudo-terminal in a background thread.
+// Copies the path of the terminal to connect to into tty.
+bool rcs956_sim_start(const struct rcs956_sim_config *config,
+                      char *tty, size_t tty_size);
+
+// Changes the phone in the field.
+void rcs956_sim_set_phone(enum rcs956_sim_phone phone);
+
+// Copies and clears the statistics.
+void rcs956_sim_get_stats(struct rcs956_sim_stats *stats);
+void rcs956_sim_reset_stats(void);
+
+#endif /* __RCS956_SIM_H__ */
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Stand-alone simulated RC-S956 module. Prints the pseudo-terminal to
+ * use as RCS956_TTY and serves commands until killed.
+ *
+ *   rcs956_sim [-p none|felica|llcp|type3] [-c name=us]...
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "rcs956_sim.h"
+
+int main(int argc, char *argv[])
+{
+  struct rcs956_sim_config config;
+  char tty[64];
+  int opt;
+
+  rcs956_sim_default_config(&config);
+  while ((opt = getopt(argc, argv, "p:c:")) != -1) {
+    switch (opt) {
+      case 'p':
+        if (!rcs956_sim_parse_phone(optarg, &config.phone))
+          goto usage;
+        break;
+      case 'c':
+        if (!rcs956_sim_configure(&config, optarg))
+          goto usage;
+        break;
+      default:
+        goto usage;
+    }
+  }
+
+  if (!rcs956_sim_start(&config, tty, sizeof(tty))) {
+    fprintf(stderr, "cannot open pseudo-terminal\n");
+    return 1;
+  }
+  printf("RCS956_TTY=%s\n", tty);
+  fflush(stdout);
+  for (;;) {
+    pause();
+  }
+
+usage:
+  fprintf(stderr, "usage: %s [-p none|felica|llcp|type3] [-c name=us]\n",
+          argv[0]);
+  return 2;
+}
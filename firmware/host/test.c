@@ -0,0 +1,56 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Host version of test/test.c. Reports results on stdout/stderr and
+ * exits with a non-zero status on the first failure.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test/test.h"
+
+int num_tests = 0;
+static const char *__current_test = "";
+
+void assert_msg(bool condition, char* msg)
+{
+  if (!condition) {
+    fprintf(stderr, "FAIL %s: %s\n", __current_test,
+            (msg != NULL) ? msg : "FAIL");
+    exit(1);
+  }
+}
+
+void assert(bool condition)
+{
+  assert_msg(condition, NULL);
+}
+
+void test(char *name)
+{
+  num_tests++;
+  __current_test = name;
+}
+
+void test_init(void)
+{
+}
+
+void success() {
+  printf("%i tests OK!\n", num_tests);
+  exit(0);
+}
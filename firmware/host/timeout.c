@@ -0,0 +1,53 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Host version of peripheral/timeout.c based on the monotonic clock.
+ */
+
+#include <time.h>
+
+#include "peripheral/timeout.h"
+
+static struct timespec __deadline;
+static bool __running = false;
+
+void timeout_start(uint16_t ms)
+{
+  clock_gettime(CLOCK_MONOTONIC, &__deadline);
+  __deadline.tv_sec += ms / 1000;
+  __deadline.tv_nsec += (ms % 1000) * 1000000L;
+  if (__deadline.tv_nsec >= 1000000000L) {
+    __deadline.tv_sec++;
+    __deadline.tv_nsec -= 1000000000L;
+  }
+  __running = true;
+}
+
+bool timeout_expired(void)
+{
+  struct timespec now;
+
+  if (!__running)
+    return false;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec > __deadline.tv_sec ||
+          (now.tv_sec == __deadline.tv_sec &&
+           now.tv_nsec >= __deadline.tv_nsec));
+}
+
+void timeout_stop(void)
+{
+  __running = false;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Host version of peripheral/timer.c based on the monotonic clock.
+ * TIMER_RES_CLOCK reports elapsed time converted to F_CPU cycles, so
+ * numbers are comparable in unit (not in value) with the AVR.
+ */
+
+#include <stdbool.h>
+#include <time.h>
+
+#include "peripheral/timer.h"
+
+static struct timespec __start;
+static unsigned int __frozen;
+static enum TIMER_RESOLUTION __resolution;
+static bool __running = false;
+
+static unsigned int __elapsed(void)
+{
+  struct timespec now;
+  unsigned long long ns;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  ns = (now.tv_sec - __start.tv_sec) * 1000000000ULL
+      + now.tv_nsec - __start.tv_nsec;
+  switch (__resolution) {
+    case TIMER_RES_CLOCK:
+      return (unsigned int)(ns * (F_CPU / 1000) / 1000000ULL);
+    case TIMER_RES_100us:
+      return (unsigned int)(ns / 100000ULL);
+    default:
+      return (unsigned int)(ns / 1000000ULL);
+  }
+}
+
+void start_timer(enum TIMER_RESOLUTION resolution)
+{
+  __resolution = resolution;
+  __running = true;
+  clock_gettime(CLOCK_MONOTONIC, &__start);
+}
+
+unsigned int get_timer()
+{
+  return __running ? __elapsed() : __frozen;
+}
+
+void stop_timer()
+{
+  if (__running) {
+    __frozen = __elapsed();
+    __running = false;
+  }
+}
+
+uint16_t trace_clock(void)
+{
+  static struct timespec epoch;
+  struct timespec now;
+  unsigned long long ns;
+
+  if (epoch.tv_sec == 0 && epoch.tv_nsec == 0) {
+    clock_gettime(CLOCK_MONOTONIC, &epoch);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  ns = (now.tv_sec - epoch.tv_sec) * 1000000000ULL
+      + now.tv_nsec - epoch.tv_nsec;
+  return (uint16_t)(ns * (F_CPU / 1000) / 1000000ULL / TRACE_CLOCK_PRESCALER);
+}
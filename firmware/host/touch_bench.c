@@ -0,0 +1,205 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Measures touch-to-push latency of initiator() and target() against the
+ * simulated RC-S956 module.
+ *
+ *   touch_bench [-n touches] [-p none|felica|llcp|type3] [-c name=us]...
+ *   touch_bench -s [-n cycles] [-c name=us]...
+ *
+ * Without -p all phones that complete a touch are measured. With -s the
+ * station main loop runs without a phone, and the time per cycle the
+ * module is not listening for phones is compared between a full reset
+ * and rcs956_in_release when switching to target mode. See
+ * rcs956_sim_configure for the -c timing parameters, e.g. -c detect=8000
+ * or -c a0=2500 (CommunicateThruEX module latency).
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "initiator.h"
+#include "rcs956/rcs956_common.h"
+#include "rcs956/rcs956_initiator.h"
+#include "rcs956/rcs956_protocol.h"
+#include "target.h"
+
+#include "host.h"
+#include "rcs956_sim.h"
+
+#define PUSH_URL_LABEL "Google Place"
+
+static const char *phone_names[] = {"none", "felica", "llcp", "type3"};
+
+static double __ms_since(const struct timespec *t)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - t->tv_sec) * 1e3 + (now.tv_nsec - t->tv_nsec) / 1e6;
+}
+
+/*
+ * Runs count touches with the given phone and prints the latency seen
+ * by the module and the time spent in initiator() or target().
+ */
+static void __bench(enum rcs956_sim_phone phone, int count)
+{
+  struct rcs956_sim_stats stats;
+  struct timespec start;
+  enum touch_kind kind;
+  double call_ms = 0;
+  int ok = 0;
+  int i;
+
+  rcs956_sim_set_phone(phone);
+  rcs956_sim_reset_stats();
+  for (i = 0; i < count; i++) {
+    rcs956_reset();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (phone == SIM_PHONE_FELICA || phone == SIM_PHONE_NONE) {
+      initiator_set_defaults();
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      ok += initiator(PUSH_URL_LABEL);
+    } else {
+      ok += (target(PUSH_URL_LABEL, &kind) == TGT_COMPLETE);
+    }
+    call_ms += __ms_since(&start);
+  }
+  rcs956_sim_get_stats(&stats);
+
+  printf("%-7s %s %d/%d ok, call avg %.2f ms", phone_names[phone],
+         (phone == SIM_PHONE_LLCP || phone == SIM_PHONE_TYPE3)
+             ? "target   " : "initiator",
+         ok, count, call_ms / count);
+  if (stats.touches > 0) {
+    printf(", touch-to-push min %.2f avg %.2f max %.2f ms",
+           stats.min_us / 1e3, stats.total_us / 1e3 / stats.touches,
+           stats.max_us / 1e3);
+  }
+  printf(", %u frames %u cancels\n", stats.frames, stats.cancels);
+}
+
+/*
+ * One pass of the WITH_TARGET main loop in station_rcs956.c, without
+ * user feedback and target retries.
+ */
+static void __station_cycle(bool in_release)
+{
+  enum touch_kind kind;
+
+  (void)initiator(PUSH_URL_LABEL);
+  if (!in_release || !rcs956_in_release()) {
+    (void)rcs956_reset();
+  }
+  (void)target(PUSH_URL_LABEL, &kind);
+  (void)rcs956_reset();
+  if (protocol_errno == TIMEOUT) {
+    initiator_set_defaults();
+  }
+  protocol_errno = SUCCESS;
+}
+
+/*
+ * Runs count station cycles with no phone in the field and prints the
+ * time per cycle the module was not listening for phones.
+ */
+static void __bench_cycle(bool in_release, int count)
+{
+  struct rcs956_sim_stats stats;
+  struct timespec start;
+  double cycle_ms;
+  int i;
+
+  rcs956_sim_set_phone(SIM_PHONE_NONE);
+  rcs956_reset();
+  initiator_set_defaults();
+  rcs956_sim_reset_stats();
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < count; i++) {
+    __station_cycle(in_release);
+  }
+  cycle_ms = __ms_since(&start) / count;
+  rcs956_sim_get_stats(&stats);
+
+  printf("cycle   %s cycle avg %.2f ms, deaf %.2f ms/cycle, "
+         "%u frames %u cancels\n",
+         in_release ? "release" : "reset  ", cycle_ms,
+         cycle_ms - stats.listen_us / 1e3 / count,
+         stats.frames / count, stats.cancels / count);
+}
+
+int main(int argc, char *argv[])
+{
+  struct rcs956_sim_config config;
+  enum rcs956_sim_phone phone = SIM_PHONE_NONE;
+  bool all = true;
+  bool cycle = false;
+  char tty[64];
+  int count = 20;
+  int opt;
+
+  rcs956_sim_default_config(&config);
+  while ((opt = getopt(argc, argv, "n:p:c:s")) != -1) {
+    switch (opt) {
+      case 'n':
+        count = atoi(optarg);
+        break;
+      case 'p':
+        if (!rcs956_sim_parse_phone(optarg, &phone))
+          goto usage;
+        all = false;
+        break;
+      case 'c':
+        if (!rcs956_sim_configure(&config, optarg))
+          goto usage;
+        break;
+      case 's':
+        cycle = true;
+        break;
+      default:
+        goto usage;
+    }
+  }
+  if (count <= 0)
+    goto usage;
+
+  if (!rcs956_sim_start(&config, tty, sizeof(tty)) || !usart_host_open(tty)) {
+    fprintf(stderr, "cannot open pseudo-terminal\n");
+    return 1;
+  }
+
+  if (cycle) {
+    __bench_cycle(false, count);
+    __bench_cycle(true, count);
+  } else if (all) {
+    __bench(SIM_PHONE_FELICA, count);
+    __bench(SIM_PHONE_LLCP, count);
+    __bench(SIM_PHONE_TYPE3, count);
+  } else {
+    __bench(phone, count);
+  }
+  return 0;
+
+usage:
+  fprintf(stderr,
+          "usage: %s [-n touches] [-p none|felica|llcp|type3] [-c name=us]\n"
+          "       %s -s [-n cycles] [-c name=us]\n",
+          argv[0], argv[0]);
+  return 2;
+}
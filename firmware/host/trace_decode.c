@@ -0,0 +1,137 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Prints the trace dumps (see ../trace.h) found in a USART capture or a
+ * raw EEPROM read.
+ *
+ *   trace_decode [file]
+ *
+ * Reads stdin without a file. Times are relative to the oldest record.
+ * Gaps longer than one wrap of the trace clock (about 4.7s) show as
+ * shorter ones.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "trace.h"
+
+// EEPROM reads are 1KB, USART captures may hold many dumps
+#define MAX_INPUT 65536
+
+static const char *event_names[NUM_TRACE_EVENTS] = {
+  [TRACE_NONE] = "-",
+  [TRACE_POLL_START] = "POLL_START",
+  [TRACE_POLL_END] = "POLL_END",
+  [TRACE_TARGET_START] = "TARGET_START",
+  [TRACE_TARGET_END] = "TARGET_END",
+  [TRACE_URL_BUILD] = "URL_BUILD",
+  [TRACE_URL_BUILT] = "URL_BUILT",
+  [TRACE_RCS956_CMD] = "RCS956_CMD",
+  [TRACE_RCS956_ACK] = "RCS956_ACK",
+  [TRACE_RCS956_RESP] = "RCS956_RESP",
+  [TRACE_RCS956_CANCEL] = "RCS956_CANCEL",
+  [TRACE_LLCP_STATE] = "LLCP_STATE",
+  [TRACE_EEPROM_WRITE] = "EEPROM_WRITE",
+  [TRACE_TOUCH] = "TOUCH",
+};
+
+static uint16_t __get16(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+/*
+ * Prints the dump at buf if it is one. Returns its length, 0 if not.
+ */
+static size_t __decode(const uint8_t *buf, size_t len)
+{
+  const uint8_t *record;
+  uint8_t count;
+  uint16_t tick;
+  uint16_t prev;
+  unsigned long long ticks = 0;
+  size_t size;
+  uint8_t i;
+
+  if (len < TRACE_HEADER_BYTES || buf[0] != 'T' || buf[1] != 'R'
+      || buf[2] != TRACE_FORMAT) {
+    return 0;
+  }
+  count = buf[3];
+  tick = __get16(&buf[4]);
+  size = TRACE_HEADER_BYTES + count * TRACE_RECORD_BYTES;
+  if (tick == 0 || size > len) {
+    return 0;
+  }
+
+  printf("%u records, tick %.2fus\n", count, tick / 100.0);
+  printf("%12s %12s  %-14s %s\n", "time ms", "delta ms", "event", "arg");
+  record = &buf[TRACE_HEADER_BYTES];
+  prev = count > 0 ? __get16(&record[2]) : 0;
+  for (i = 0; i < count; i++, record += TRACE_RECORD_BYTES) {
+    uint16_t time = __get16(&record[2]);
+    uint16_t delta = time - prev;
+    const char *name = record[0] < NUM_TRACE_EVENTS
+        ? event_names[record[0]] : "?";
+
+    ticks += delta;
+    prev = time;
+    printf("%12.3f %+12.3f  %-14s ", ticks * tick / 1e5, delta * tick / 1e5,
+           name);
+    if (record[0] == TRACE_RCS956_CMD) {
+      printf("0x%02x\n", record[1]);
+    } else {
+      printf("%u\n", record[1]);
+    }
+  }
+  return size;
+}
+
+int main(int argc, char *argv[])
+{
+  static uint8_t buf[MAX_INPUT];
+  FILE *in = stdin;
+  size_t len;
+  size_t i;
+  unsigned dumps = 0;
+
+  if (argc > 2) {
+    fprintf(stderr, "usage: %s [file]\n", argv[0]);
+    return 2;
+  }
+  if (argc == 2 && (in = fopen(argv[1], "rb")) == NULL) {
+    perror(argv[1]);
+    return 1;
+  }
+  len = fread(buf, 1, sizeof(buf), in);
+
+  for (i = 0; i < len; i++) {
+    size_t size = __decode(&buf[i], len - i);
+
+    if (size > 0) {
+      if (dumps++ > 0) {
+        printf("\n");
+      }
+      i += size - 1;
+    }
+  }
+  if (dumps == 0) {
+    fprintf(stderr, "no trace found\n");
+    return 1;
+  }
+  return 0;
+}
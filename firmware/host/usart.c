@@ -0,0 +1,200 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Host version of peripheral/usart.c. The USART is a file descriptor
+ * for a tty or pseudo-terminal named by the RCS956_TTY environment
+ * variable. Received bytes go through the same ring buffer as on the
+ * AVR; the buffer is filled when the caller polls instead of from the
+ * RX interrupt.
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "peripheral/usart.h"
+
+#include "host.h"
+
+static int __usart_fd = -1;
+static uint8_t __usart_buffer[RECEIVE_BUFFER_SIZE];
+static uint8_t __usart_buffer_write_index;
+static uint8_t __usart_buffer_read_index;
+static usart_receive_handler __usart_handler;
+
+/*
+ * Moves pending bytes from the descriptor into the ring buffer, like the
+ * RX interrupt does on the AVR. A receive handler gets one byte per call,
+ * as each RX interrupt wakes up the sleeping AVR. Returns true if any
+ * byte was received.
+ */
+static bool __usart_receive(void)
+{
+  bool received = false;
+  uint8_t c;
+
+  if (__usart_fd < 0)
+    return false;
+  if (__usart_handler != NULL) {
+    if (read(__usart_fd, &c, 1) != 1)
+      return false;
+    __usart_handler(c);
+    return true;
+  }
+  while ((uint8_t)(__usart_buffer_write_index - __usart_buffer_read_index)
+         < RECEIVE_BUFFER_SIZE && read(__usart_fd, &c, 1) == 1) {
+    received = true;
+    __usart_buffer[__usart_buffer_write_index++
+        & (RECEIVE_BUFFER_SIZE - 1)] = c;
+  }
+  return received;
+}
+
+/*
+ * Opens the serial device in raw mode. Returns true on success.
+ */
+bool usart_host_open(const char *path)
+{
+  struct termios tio;
+
+  if (__usart_fd >= 0)
+    close(__usart_fd);
+  __usart_fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (__usart_fd < 0)
+    return false;
+  if (tcgetattr(__usart_fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, B115200);
+    tcsetattr(__usart_fd, TCSANOW, &tio);
+  }
+  return true;
+}
+
+/*
+ * Waits up to ms milliseconds for data. Returns true if data is ready or
+ * went to the receive handler.
+ */
+bool usart_host_wait(uint16_t ms)
+{
+  struct pollfd pfd;
+
+  if (__usart_receive() || usart_has_data())
+    return true;
+  if (__usart_fd < 0) {
+    poll(NULL, 0, ms);
+    return false;
+  }
+  pfd.fd = __usart_fd;
+  pfd.events = POLLIN;
+  if (poll(&pfd, 1, ms) <= 0)
+    return false;
+  return (__usart_receive() || usart_has_data());
+}
+
+/*
+ * Opens the device named by RCS956_TTY, if any. Without a device, sent
+ * bytes are dropped and reads time out as if the module were unplugged.
+ */
+void usart_init(void)
+{
+  const char *path = getenv(HOST_USART_ENV);
+
+  if (path != NULL && __usart_fd < 0)
+    (void)usart_host_open(path);
+}
+
+void usart_disable(void)
+{
+  if (__usart_fd >= 0)
+    close(__usart_fd);
+  __usart_fd = -1;
+}
+
+void usart_set_receive_handler(usart_receive_handler handler)
+{
+  __usart_handler = handler;
+}
+
+bool usart_has_data(void)
+{
+  __usart_receive();
+  return (__usart_buffer_write_index != __usart_buffer_read_index);
+}
+
+uint8_t usart_get(void)
+{
+  while (!usart_host_wait(10)) {};
+
+  return __usart_buffer[__usart_buffer_read_index++
+      & (RECEIVE_BUFFER_SIZE - 1)];
+}
+
+void usart_send(uint8_t c)
+{
+  usart_send_buf(&c, 1);
+}
+
+void usart_send_buf(const uint8_t* buf, int len)
+{
+  struct pollfd pfd;
+  ssize_t n;
+
+  if (__usart_fd < 0)
+    return;
+  pfd.fd = __usart_fd;
+  pfd.events = POLLOUT;
+  while (len > 0) {
+    n = write(__usart_fd, buf, len);
+    if (n > 0) {
+      buf += n;
+      len -= n;
+    } else if (poll(&pfd, 1, 100) < 0) {
+      return;
+    }
+  }
+}
+
+void usart_send_buf_p(const prog_char* buf, int len)
+{
+  usart_send_buf((const uint8_t *)buf, len);
+}
+
+/*
+ * Sending writes straight to the descriptor, so there is never anything
+ * queued.
+ */
+bool usart_send_done(void)
+{
+  return true;
+}
+
+void usart_flush(void)
+{
+}
+
+/*
+ * Empties the receive buffer, including bytes not yet picked up from
+ * the descriptor.
+ */
+void usart_clear_receive_buffer(void)
+{
+  __usart_receive();
+  while (__usart_buffer_write_index != __usart_buffer_read_index) {
+    __usart_buffer_write_index = __usart_buffer_read_index = 0;
+    __usart_receive();
+  }
+}
@@ -22,14 +22,16 @@
 
 #include "nfc_url2.h"
 #include "initiator.h"
+#include "histogram.h"
 #include "nfc/felica_push.h"
-#include "peripheral/lcd.h"
+#include "peripheral/log.h"
 #include "peripheral/led.h"
 #include "peripheral/timer.h"
 #include "peripheral/usart.h"
 #include "rcs956/rcs956_common.h"
 #include "rcs956/rcs956_initiator.h"
 #include "rcs956/rcs956_protocol.h"
+#include "trace.h"
 
 /*
  * For only polling Mobile Felica, in other words Osaifu-Keitai, the poll
@@ -37,15 +39,86 @@
  */
 #define SYSCODE_MOBILE 0xfe0f
 
-// Adapter method to create URL in place
+/*
+ * URL parameters built for recently seen phones, so that phones
+ * alternating on the reader do not pay for AES and the checksum on every
+ * touch. Only the encrypted v parameter is kept; the push frame around it
+ * is base64 encoded again on each use. A parameter carries a URL counter.
+ * It is kept for retrying a failed push, and a successful push uses it up
+ * after PUSH_CACHE_MAX_PUSHES. The default of 1 gives every successful
+ * touch a new URL; larger values give a returning phone the same URL
+ * again. An entry unused for PUSH_CACHE_MAX_AGE initiator() calls
+ * expires, so that a stale counter is not served long after it was built.
+ */
+struct push_param {
+  uint8_t idm[IDM_LENGTH];
+  uint8_t len;     // 0 if the entry is unused
+  uint8_t pushes;  // successful pushes of this parameter
+  uint8_t age;     // initiator() calls since last use
+  uint8_t param[URL_PARAM_BYTES];
+};
+
+static struct push_param push_cache[PUSH_CACHE_ENTRIES];
+
+/*
+ * Adapter method to create URL in place, extra is the cache entry. A
+ * kept parameter is reused, otherwise a new URL is built and kept.
+ */
 static uint8_t get_url(uint8_t *buf, uint8_t buf_size, void *extra)
 {
-  // Pass extra arg as IDm
-  if (build_url((char *)buf, buf_size, (uint8_t *)extra)) {
-    return strlen((char *)buf);
-  } else {
-    return 0;
+  struct push_param *push = (struct push_param *)extra;
+  uint8_t *id = push->idm;
+
+  if (push->len > 0) {
+    return rebuild_url((char *)buf, buf_size, push->param, push->len);
+  }
+#ifdef FAKE_IDM
+  id = NULL;
+#endif /* FAKE_IDM */
+  return build_url_param((char *)buf, buf_size, id, push->param, &push->len);
+}
+
+/*
+ * Ages all cache entries by one initiator() call and drops the expired.
+ */
+static void __age_push_cache(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < PUSH_CACHE_ENTRIES; i++) {
+    if (push_cache[i].age < PUSH_CACHE_MAX_AGE) {
+      push_cache[i].age++;
+    } else {
+      push_cache[i].len = 0;
+    }
+  }
+}
+
+/*
+ * Returns the cache entry holding the URL parameter for idm. If there is
+ * none, the least recently used entry is emptied and assigned to idm.
+ */
+static struct push_param *__lookup_push_cache(const uint8_t idm[])
+{
+  struct push_param *entry = push_cache;
+  uint8_t i;
+
+  for (i = 0; i < PUSH_CACHE_ENTRIES; i++) {
+    if (push_cache[i].len > 0 &&
+        memcmp(push_cache[i].idm, idm, IDM_LENGTH) == 0) {
+      push_cache[i].age = 0;
+      return &push_cache[i];
+    }
+    if (entry->len > 0 &&
+        (push_cache[i].len == 0 || push_cache[i].age > entry->age)) {
+      entry = &push_cache[i];
+    }
   }
+  memcpy(entry->idm, idm, IDM_LENGTH);
+  entry->len = 0;
+  entry->pushes = 0;
+  entry->age = 0;
+  return entry;
 }
 
 /*
@@ -58,43 +131,55 @@ static uint8_t get_url(uint8_t *buf, uint8_t buf_size, void *extra)
 bool initiator(const char push_label[])
 {
   uint8_t idm[IDM_LENGTH];
-  uint8_t idm_previous[IDM_LENGTH];
-  uint8_t buffer[URL_LENGTH+30]; // extra for label + header
   uint8_t resp[128];
-  uint8_t len = 0;
+  uint8_t frame[URL_LENGTH+30]; // extra for label + header
+  uint8_t frame_len;
+  struct push_param *push;
   bool pushed_url = false;
   bool detected_phone;
   uint8_t number_retries = 0;
 
-  memset(idm_previous, 0, IDM_LENGTH);
+  __age_push_cache();
   do {
-    lcd_puts(0, "POLL");
+    log_puts(LOG_DEBUG, 0, "POLL");
+    trace(TRACE_POLL_START, 0);
     start_timer(TIMER_RES_1ms);
-    detected_phone = initiator_poll(idm, NULL, SYSCODE_MOBILE);
+    detected_phone = initiator_poll_start(resp, sizeof(resp), SYSCODE_MOBILE);
+    if (detected_phone) {
+      // Encrypt ahead while the module polls, which takes up to ~400ms
+      precompute_url();
+      detected_phone = initiator_poll_finish(resp, idm, NULL);
+    }
     stop_timer();
+    trace(TRACE_POLL_END, detected_phone);
     if (!detected_phone) {
       break;
     }
     // Phone detected
-    lcd_printf(0, "PUSH URL  %ims", get_timer());
-    lcd_print_hex(1, idm, IDM_LENGTH);
+    histogram_add(HIST_POLL_TO_DETECT, get_timer());
+    log_printf(LOG_DEBUG, 0, "PUSH URL  %ims", get_timer());
+    log_hex(LOG_DEBUG, 1, idm, IDM_LENGTH);
     led_on();
+    start_timer(TIMER_RES_1ms);
 
-    // Do not recompute URL for same phone (keep same counter)
-    if (memcmp(idm, idm_previous, IDM_LENGTH) != 0) {
-      uint8_t *id = idm;
-#ifdef FAKE_IDM
-      id = NULL;
-#endif /* FAKE_IDM */
-      start_timer(TIMER_RES_1ms);
-      len = felica_push_url(buffer, sizeof(buffer),
-                            idm, get_url, id, push_label);
-      memcpy(idm_previous, idm, IDM_LENGTH);
-      stop_timer();
-      lcd_printf(0, "URL %ims %iB", get_timer(), len);
+    // Do not recompute URL for a cached phone (keep same counter)
+    push = __lookup_push_cache(idm);
+    frame_len = felica_push_url(frame, sizeof(frame),
+                                idm, get_url, push, push_label);
+    if (frame_len == 0) {
+      push->len = 0;
+    }
+    log_printf(LOG_DEBUG, 0, "URL at %ims %iB", get_timer(), frame_len);
+    rcs956_comm_thru_ex(frame, frame_len,
+                        resp, sizeof(resp), IN_COMM_TIMEOUT_MS);
+    stop_timer();
+    pushed_url = is_felica_push_response(resp + OFS_DATA + 1, frame_len);
+    if (pushed_url) {
+      histogram_add(HIST_TOUCH_TO_PUSH, get_timer());
+    }
+    if (pushed_url && ++push->pushes >= PUSH_CACHE_MAX_PUSHES) {
+      push->len = 0; // URL used up, next touch gets a new counter
     }
-    rcs956_comm_thru_ex(buffer, len, resp, sizeof(resp), IN_COMM_TIMEOUT_MS);
-    pushed_url = is_felica_push_response(resp + OFS_DATA + 1, len);
     rcs956_rf_off(); // seems to be needed for reseting status in Android.
   } while (!pushed_url && number_retries++ < NUM_RETRY_INITIATOR_LOOP);
   led_off();
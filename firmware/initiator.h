@@ -29,6 +29,19 @@
 #define TIMEOUT_STYLE 0x0d /* 50 * 2^(TIMEOUT_STYLE) [us] i.e. ~400ms*/
 #define IN_COMM_TIMEOUT_MS 1000
 
+// Number of phones whose URL parameters are kept, 68 bytes each
+#ifndef PUSH_CACHE_ENTRIES
+#define PUSH_CACHE_ENTRIES 3
+#endif
+// Successful pushes of the same URL (counter) to a returning phone
+#ifndef PUSH_CACHE_MAX_PUSHES
+#define PUSH_CACHE_MAX_PUSHES 1
+#endif
+// initiator() calls after which an unused URL parameter is dropped
+#ifndef PUSH_CACHE_MAX_AGE
+#define PUSH_CACHE_MAX_AGE 20
+#endif
+
 // Main initiator feature. Pools for phone and pushes URL.
 bool initiator(const char push_label[]);
 
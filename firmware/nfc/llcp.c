@@ -22,7 +22,8 @@
 #include <avr/io.h>
 #include <avr/pgmspace.h>
 
-#include "../peripheral/lcd.h"
+#include "../peripheral/log.h"
+#include "../trace.h"
 
 #include "llcp.h"
 
@@ -159,7 +160,7 @@ static uint8_t __make_info_pdu(uint8_t *buf, uint8_t dsap)
  * -> DM 0
  */
 
-uint8_t get_llcp_command( uint8_t *cmd, uint8_t *resp, llcp_ctx *context)
+static uint8_t __llcp_command(uint8_t *cmd, uint8_t *resp, llcp_ctx *context)
 {
   uint8_t ptype = __get_ptype(resp);
   switch (context->state) {
@@ -167,7 +168,7 @@ uint8_t get_llcp_command( uint8_t *cmd, uint8_t *resp, llcp_ctx *context)
       switch (ptype) {
         case PDU_CONNECT:
           // Do not accept connections
-          lcd_printf(0, "<- DM");
+          log_printf(LOG_DEBUG, 0, "<- DM");
           __make_service_pdu(PDU_DM, context->dsap, cmd);
           cmd[2] = 0x11; // reason: we do not accept CONN requests
           context->state = LLCP_DONE;
@@ -175,7 +176,7 @@ uint8_t get_llcp_command( uint8_t *cmd, uint8_t *resp, llcp_ctx *context)
 
         default:
           // Send CONN to get started (regardless of what we received)
-          lcd_printf(0, "<- CONN [0->1] %i", context->dsap);
+          log_printf(LOG_DEBUG, 0, "<- CONN [0->1] %i", context->dsap);
           context->state = LLCP_CONN_PENDING;
           __make_service_pdu(PDU_CONNECT, context->dsap, cmd);
           if (context->dsap != DSAP_DISC) {
@@ -197,26 +198,26 @@ uint8_t get_llcp_command( uint8_t *cmd, uint8_t *resp, llcp_ctx *context)
           // Connection confirmed -> set dsap & reply with I pdu
           // Caller has to append payload data
           context->dsap = resp[1] & 0x1f;
-          lcd_printf(0, "-> CC [1] %i", context->dsap);
+          log_printf(LOG_DEBUG, 0, "-> CC [1] %i", context->dsap);
           uint8_t size = __make_info_pdu(cmd, context->dsap);
-          lcd_printf(0, "<- I [1->2]");
+          log_printf(LOG_DEBUG, 0, "<- I [1->2]");
           context->state = LLCP_CONNECTED;
           return size;
 
         case PDU_SYMM:
           // Reply to SYMM with SYMM while waiting for connection.
-          lcd_printf(0, "<-> SYMM [1]");
+          log_printf(LOG_DEBUG, 0, "<-> SYMM [1]");
           __make_pdu(PDU_SYMM, 0, 0, cmd);
           return 2;
 
         case PDU_DM:
           // Connection request not honored
-          lcd_printf(0, "-> DM [1] %i", resp[llcp_header_len(resp)]);
+          log_printf(LOG_DEBUG, 0, "-> DM [1] %i", resp[llcp_header_len(resp)]);
           context->state = LLCP_REJECT;
           return 0;
 
         default:
-          lcd_print_hex(1, resp, 8);
+          log_hex(LOG_ERROR, 1, resp, 8);
       }
       break;
 
@@ -224,8 +225,9 @@ uint8_t get_llcp_command( uint8_t *cmd, uint8_t *resp, llcp_ctx *context)
       switch (ptype) {
         case PDU_I:
           // Acknowlegde response from initiator
-          lcd_printf(0, "-> I %i [2]", resp[1 + llcp_header_len(resp)]);
-          lcd_printf(0, "<- RR [2->3]");
+          log_printf(LOG_DEBUG, 0, "-> I %i [2]",
+                     resp[1 + llcp_header_len(resp)]);
+          log_printf(LOG_DEBUG, 0, "<- RR [2->3]");
           __make_service_pdu(PDU_RR, DSAP_SNEP, cmd);
           cmd[2] = resp[2]; // Sequence number
           context->state = LLCP_CONFIRMED;
@@ -233,26 +235,26 @@ uint8_t get_llcp_command( uint8_t *cmd, uint8_t *resp, llcp_ctx *context)
 
         case PDU_RR:
           // Receive ready from initiator
-          lcd_printf(0, "-> RR %i [2]", resp[2]);
+          log_printf(LOG_DEBUG, 0, "-> RR %i [2]", resp[2]);
           // Reply with SYMM as nothing more to send
-          lcd_printf(0, "<- SYMM [2]");
+          log_printf(LOG_DEBUG, 0, "<- SYMM [2]");
           __make_pdu(PDU_SYMM, 0, 0, cmd);
           return 2;
 
         case PDU_SYMM:
           // Reply to SYMM with SYMM while waiting for confirmation.
-          lcd_printf(0, "<-> SYMM [1]");
+          log_printf(LOG_DEBUG, 0, "<-> SYMM [1]");
           __make_pdu(PDU_SYMM, 0, 0, cmd);
           return 2;
 
         default:
-          lcd_print_hex(1, resp, 8);
+          log_hex(LOG_ERROR, 1, resp, 8);
       }
       break;
 
     case LLCP_CONFIRMED:
       // Disconnect.
-      lcd_printf(0, "<- DISC [3->4]");
+      log_printf(LOG_DEBUG, 0, "<- DISC [3->4]");
       __make_service_pdu(PDU_DISC, context->dsap, cmd);
       context->state = LLCP_DISCONNECTING;
       return 2;
@@ -260,7 +262,7 @@ uint8_t get_llcp_command( uint8_t *cmd, uint8_t *resp, llcp_ctx *context)
     case LLCP_DISCONNECTING:
       // We disconnected, so ignore everything except DM.
       if (ptype == PDU_DM) {
-        lcd_printf(0, "-> DM %i [4]", resp[2]);
+        log_printf(LOG_DEBUG, 0, "-> DM %i [4]", resp[2]);
         context->state = LLCP_DONE;
       }
       break;
@@ -271,3 +273,14 @@ uint8_t get_llcp_command( uint8_t *cmd, uint8_t *resp, llcp_ctx *context)
   }
   return 0;
 }
+
+uint8_t get_llcp_command(uint8_t *cmd, uint8_t *resp, llcp_ctx *context)
+{
+  uint8_t state = context->state;
+  uint8_t len = __llcp_command(cmd, resp, context);
+
+  if (context->state != state) {
+    trace(TRACE_LLCP_STATE, context->state);
+  }
+  return len;
+}
@@ -20,11 +20,47 @@
 
 #include <string.h>
 
+#include <avr/pgmspace.h>
+
 #include "sp.h"
 
+/*
+ * Abbreviated URI prefixes, identifier code 0x01 onwards. See "URI Record
+ * Type Definition". Only the web prefixes are listed as make_url supplies
+ * URLs for the browser. Code 0x00 stands for no abbreviation.
+ */
+static const prog_char __uri_prefixes[][13] = {
+  "http://www.",
+  "https://www.",
+  "http://",
+  "https://",
+};
+
+/*
+ * Finds the URI identifier code with the longest prefix matching url.
+ * Returns the code, 0 if none matches, and the prefix length.
+ */
+static uint8_t __uri_code(const char *url, uint8_t *prefix_len)
+{
+  uint8_t code = 0;
+  uint8_t i, len;
+
+  *prefix_len = 0;
+  for (i = 0; i < sizeof(__uri_prefixes) / sizeof(__uri_prefixes[0]); i++) {
+    len = strlen_P(__uri_prefixes[i]);
+    if (len > *prefix_len && strncmp_P(url, __uri_prefixes[i], len) == 0) {
+      code = i + 1;
+      *prefix_len = len;
+    }
+  }
+  return code;
+}
+
 /**
  * Populates a buffer with a NDEF Smart Poster record.
  * If a label is provided (not NULL), includes a Title record.
+ * The URL prefix is replaced by its URI identifier code if it has one;
+ * make_url is told to leave it out, so the URL is written in place.
  *
  * Based on the following specifications:
  * NFC Data Exchange Format (NDEF)
@@ -37,6 +73,7 @@
  * buf: the buffer to hold the Smart Poster binary image
  * buf_size: Size of the available buffer
  * label: optional label to include as Title record
+ * url_prefix: start of every URL make_url supplies, may be NULL
  * make_url: pointer to function that supplies the URL
  * extra: any extra parameters to be passed to make_url
  *
@@ -45,10 +82,10 @@
  */
 uint8_t
 smart_poster(uint8_t *buf, uint8_t buf_size, const char *label,
-            make_url_fp make_url, void *extra)
+             const char *url_prefix, make_uri_fp make_url, void *extra)
 {
   uint8_t idx, len_idx, sp_head, url_len_idx;
-  uint8_t url_len;
+  uint8_t url_len, prefix_len = 0;
 
   // Min size needed for a 1 character URL
   if (buf_size < 10) {
@@ -89,18 +126,19 @@ smart_poster(uint8_t *buf, uint8_t buf_size, const char *label,
   buf[idx++] = 0x01; // Record name length.
   url_len_idx = idx++; // Filled below.
   buf[idx++] = 'U'; // URL type.  See "URI Record Type Definition".
-  buf[idx++] = 0x00; // String is literal URL incl protocol.
+  // URI identifier code standing for the prefix
+  buf[idx++] = url_prefix ? __uri_code(url_prefix, &prefix_len) : 0;
 
-  // Append URL to be sent.
-  if (!((*make_url)(&buf[idx], buf_size - idx, extra))) {
+  // Append URL to be sent, without the abbreviated prefix.
+  url_len = (*make_url)(&buf[idx], buf_size - idx, prefix_len, extra);
+  if (url_len == 0) {
     return 0;
   }
-  url_len = strlen((char*)&buf[idx]);
   idx += url_len;
 
   // Fill in length bytes
   buf[len_idx] = idx - sp_head;
-  buf[url_len_idx] = url_len + 1; // sizeof 'U'
+  buf[url_len_idx] = url_len + 1; // identifier code + URL
 
   return idx;
 }
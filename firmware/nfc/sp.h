@@ -24,12 +24,15 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-// Function to supply the URL.
-typedef bool (*make_url_fp) (uint8_t *buf, uint8_t buf_size, void* extra);
+// Function to supply the URL without its first skip characters.
+// Returns the length written, 0 on error.
+typedef uint8_t (*make_uri_fp) (uint8_t *buf, uint8_t buf_size,
+                                uint8_t skip, void* extra);
 
 // Generate a smart poster record in the supplied buffer based on the URL
-// provided by the make_url function.
+// provided by the make_url function. The URL starts with url_prefix.
 uint8_t smart_poster(uint8_t *buf, uint8_t buf_size, const char *label,
-                     make_url_fp make_url, void *extra);
+                     const char *url_prefix, make_uri_fp make_url,
+                     void *extra);
 
 #endif // NFC_SP_H_
@@ -29,7 +29,7 @@
 
 #include <avr/pgmspace.h>
 
-#include "../peripheral/lcd.h"
+#include "../peripheral/log.h"
 
 #include "type3tag.h"
 
@@ -189,7 +189,7 @@ uint8_t get_type3_response(
     // 2/3: System Code
     // 4: Request Code (RC) 0x01: Include syscode
     // 5: Time Slot Number (TSN)
-    lcd_printf(0, "Felica Poll");
+    log_printf(LOG_DEBUG, 0, "Felica Poll");
     // Respond with SENSF_RES if syscode matches ours or is 0xFFFF (all)
     if ((memcmp_P(&cmd[1], card_syscode, sizeof(card_syscode)) == 0) ||
         (cmd[1] == 0xff && cmd[2] == 0xff)) {
@@ -214,7 +214,7 @@ uint8_t get_type3_response(
         // Block 0: Attribute Information Block
         resp_len = __check_response_header(resp, &cmd[1], 1);
         resp_len += attribute_block(&resp[resp_len], record_len);
-        lcd_printf(0, "Felica RD Attr");
+        log_printf(LOG_DEBUG, 0, "Felica RD Attr");
       } else {
         // Data block: Return requested blocks
         uint8_t req_blocks = cmd[12];
@@ -241,7 +241,7 @@ uint8_t get_type3_response(
           memcpy(&resp[resp_len], &record[offset], num_bytes);
           resp_len += BLOCK_SIZE;
         }
-        lcd_printf(0, "Felica RD %i %i", cmd[14]-1, req_blocks);
+        log_printf(LOG_DEBUG, 0, "Felica RD %i %i", cmd[14]-1, req_blocks);
       }
     } else {
       return false;
@@ -249,7 +249,7 @@ uint8_t get_type3_response(
     break;
 
   default:
-    lcd_printf(1, "unknwn %02X%02X%02X", cmd[0], cmd[1], cmd[2]);
+    log_printf(LOG_ERROR, 1, "unknwn %02X%02X%02X", cmd[0], cmd[1], cmd[2]);
     return false;
   }
   return resp_len;
@@ -23,19 +23,124 @@
 #include "enc.h"
 #include "eeprom_data.h"
 #include "crypto/ws_base64_enc.h"
+#include "histogram.h"
 #include "peripheral/eeprom.h"
 #include "proto/base_station.pb.h"
+#include "trace.h"
 
 #include "nfc_url2.h"
 
 static uint8_t battery_voltage = 0;
+static bool has_poll_data = false;
+static uint16_t poll_interval_ms;
+static uint8_t target_mode_retry;
+
+// Set when data above changes and the proto has to be serialized again
+static bool proto_changed = true;
 
 #ifdef WITHOUT_V_FIELD
-#define __build_v_param(X, Y, Z, H) true
+void load_station_info(void)
+{
+}
+
+void precompute_url(void)
+{
+}
+
+uint8_t url_station_info(uint8_t __attribute__((unused)) buf[],
+                         uint8_t __attribute__((unused)) size)
+{
+  return 0;
+}
+
+uint8_t url_arbitrary_data(uint8_t __attribute__((unused)) buf[],
+                           uint8_t __attribute__((unused)) size,
+                           uint32_t __attribute__((unused)) url_counter)
+{
+  return 0;
+}
 #else /* !WITHOUT_V_FIELD */
 
 #define MAX_ARBITRARY_SIZE 28
 
+/* envelope: station id + counter at the beginning, not CTR encrypted */
+#define ENVELOPE_BYTES (STATION_ID_BYTES + COUNTER_BYTES)
+
+/* whole raw v parameter: envelope, felica id, data, hash, version */
+#define MAX_V_BYTES (ENVELOPE_BYTES + IDM_BYTES + MAX_ARBITRARY_SIZE + \
+                     HASH_SIZE + VERSION_BYTES)
+#if MAX_V_BYTES != URL_PARAM_BYTES
+#error "URL_PARAM_BYTES does not match the v parameter"
+#endif
+
+/* felica id + arbitrary data + hash, rounded up to whole AES blocks */
+#define KEYSTREAM_BYTES \
+  (((IDM_BYTES + MAX_ARBITRARY_SIZE + HASH_SIZE + BLOCK_SIZE - 1) \
+    / BLOCK_SIZE) * BLOCK_SIZE)
+
+// Station id read from EEPROM together with the station key.
+static uint8_t station_id[STATION_ID_BYTES];
+static bool has_station_info = false;
+
+// Serialized proto, see __cached_proto(). The serializer may write one
+// byte past the end it is given.
+static uint8_t proto_cache[MAX_ARBITRARY_SIZE + 1];
+static uint8_t proto_cache_length;
+
+// CTR keystream for the URL counter value keystream_counter.
+static uint8_t keystream[KEYSTREAM_BYTES];
+static uint32_t keystream_counter;
+static bool has_keystream = false;
+
+/*
+ * Read station id and key from EEPROM and expand the key. Only the
+ * expanded key stays in memory.
+ */
+void load_station_info(void)
+{
+  uint8_t station_key[STATION_KEY_BYTES];
+
+  eeprom_read_station_info(station_id, station_key);
+  enc_set_key(station_key);
+  memset(station_key, 0, sizeof(station_key));
+  has_station_info = true;
+  has_keystream = false;
+}
+
+/*
+ * Write the initial CTR counter block for a URL counter value.
+ */
+static void __counter_block(uint8_t block[BLOCK_SIZE], uint32_t counter)
+{
+  memset(block, 0, BLOCK_SIZE);
+  memcpy(block, station_id, STATION_ID_BYTES);
+  memcpy(&block[STATION_ID_BYTES], &counter, sizeof(counter));
+}
+
+/*
+ * Compute the CTR keystream for the next URL counter value ahead of
+ * time. It depends only on station id, key and counter, so the next
+ * touch needs only the XOR. Does nothing if the keystream is current.
+ */
+void precompute_url(void)
+{
+  uint8_t counter[BLOCK_SIZE];
+  uint32_t next;
+
+  if (!has_station_info) {
+    load_station_info();
+  }
+  next = eeprom_read_counter() + 1;
+  if (has_keystream && keystream_counter == next) {
+    return;
+  }
+  __counter_block(counter, next);
+  memset(keystream, 0, sizeof(keystream));
+  enc128_ctr(keystream, sizeof(keystream), counter);
+  keystream_counter = next;
+  has_keystream = true;
+}
+
 /*
  * Add arbitrary data in protocol buffer format
  */
@@ -55,19 +160,136 @@ static void __fill_proto(uint8_t **tmpp, uint8_t *end)
     serialize_NfcBaseStationInfo__battery_voltage(tmpp, end,
         battery_voltage);
   }
+  if (has_poll_data) {
+    serialize_NfcBaseStationInfo__poll_interval_ms(tmpp, end,
+        poll_interval_ms);
+    serialize_NfcBaseStationInfo__target_mode_retry(tmpp, end,
+        target_mode_retry);
+  }
+}
+
+/*
+ * Returns the serialized size of the histogram whose turn it is at
+ * url_counter: tag, length and one byte per bucket, 0 if it has no counts.
+ */
+static uint8_t __histogram_size(uint32_t url_counter)
+{
+  uint8_t length = histogram_length(url_counter % NUM_HISTOGRAMS);
+
+  return length ? 2 + length : 0;
+}
+
+/*
+ * Adds one latency histogram, taking turns by URL counter. Histograms
+ * without counts are left out, and so is one that does not fit.
+ */
+static void __fill_histogram(uint8_t **tmpp, uint8_t *end,
+                             uint32_t url_counter)
+{
+  uint8_t hist = url_counter % NUM_HISTOGRAMS;
+  uint8_t length = histogram_length(hist);
+
+  if (length == 0) {
+    return;
+  }
+  switch (hist) {
+    case HIST_TOUCH_TO_PUSH:
+      serialize_NfcBaseStationInfo__touch_to_push_ms(tmpp, end,
+          histogram_counts(hist), length);
+      break;
+    case HIST_POLL_TO_DETECT:
+      serialize_NfcBaseStationInfo__poll_to_detect_ms(tmpp, end,
+          histogram_counts(hist), length);
+      break;
+    case HIST_LLCP_SESSION:
+      serialize_NfcBaseStationInfo__llcp_session_ms(tmpp, end,
+          histogram_counts(hist), length);
+      break;
+  }
+}
+
+/*
+ * Returns __fill_proto output with as much room as the URL has for it,
+ * serialized again only when a field changed.
+ */
+static uint8_t __cached_proto(void)
+{
+  if (proto_changed || eeprom_stats_changed()) {
+    uint8_t *tmpp = proto_cache;
+    eeprom_clear_stats_changed();
+    __fill_proto(&tmpp, &proto_cache[MAX_ARBITRARY_SIZE]);
+    proto_cache_length = tmpp - proto_cache;
+    proto_changed = false;
+  }
+  return proto_cache_length;
+}
+
+/*
+ * Copies the station info sent with the URL, as serialized proto, to buf.
+ * Returns its length, 0 if it does not fit.
+ */
+uint8_t url_station_info(uint8_t buf[], uint8_t size)
+{
+  uint8_t length = __cached_proto();
+
+  if (length > size) {
+    return 0;
+  }
+  memcpy(buf, proto_cache, length);
+  return length;
+}
+
+/*
+ * Writes the arbitrary data of the URL with counter url_counter to buf:
+ * the station info, then the histogram whose turn it is. The histogram's
+ * room is kept free, so the station info fields that do not fit into the
+ * rest are left out instead. A histogram of 8 buckets takes 10 bytes,
+ * leaving 18 of MAX_ARBITRARY_SIZE, enough for the five counters below
+ * 16384 and the battery voltage. A field that does not fit may write one
+ * byte past size. Returns the length written.
+ */
+uint8_t url_arbitrary_data(uint8_t buf[], uint8_t size, uint32_t url_counter)
+{
+  uint8_t *tmpp = buf;
+  uint8_t *end = &buf[size];
+  uint8_t reserved = __histogram_size(url_counter);
+  uint8_t proto_length = __cached_proto();
+
+  if (reserved > size) {
+    // Will not fit anyway
+    reserved = 0;
+  }
+  if (proto_length <= size - reserved) {
+    // Same fields as serializing into the smaller room
+    memcpy(tmpp, proto_cache, proto_length);
+    tmpp += proto_length;
+  } else {
+    __fill_proto(&tmpp, end - reserved);
+  }
+  __fill_histogram(&tmpp, end, url_counter);
+  return tmpp - buf;
 }
 
 /**
- * Generate URL paramter encoded with NFC URL version 2.
+ * Generate URL paramter encoded with NFC URL version 2 or 3.
+ *
+ * The parameter is assembled, encrypted and base64 encoded in place in
+ * url_buffer. The raw bytes start a third of the way into the space their
+ * encoding may take, so the encoder, writing 4 characters for every 3
+ * bytes, never overwrites bytes it has yet to read.
+ *
+ * Returns the number of characters written, without the NUL, or 0 if
+ * url_buffer is too small.
  */
-static bool __build_v_param(char *url_buffer, size_t url_buffer_size,
-                            uint8_t *idm, uint8_t version)
+static uint8_t __build_v_param(char *url_buffer, size_t url_buffer_size,
+                               uint8_t *idm, uint8_t version,
+                               uint8_t param[], uint8_t *param_length)
 {
   /*
    * Use station key to AES-CTR encrypt one block with:
    * felica ID (64 bit)
    * arbitrary data (0 - 224 bit)
-   * sha1 hash value (64 bit)
+   * checksum (64 bit): AES-CMAC, or SHA-1 hash for URL version 2
    *
    * Use station key to AES-ECB encrypt one block with:
    * counter (32 bit)
@@ -77,21 +299,29 @@ static bool __build_v_param(char *url_buffer, size_t url_buffer_size,
    * version (8 bit)
    */
 
-  uint8_t data[MAX_ARBITRARY_SIZE + 20 + STATION_ID_BYTES + 1];
-  uint8_t station_key[STATION_KEY_BYTES];
-  int length = 0;
+  /* longest raw parameter whose encoding fits, with the NUL */
+  size_t capacity = ((url_buffer_size - 1) * 3) / 4;
+  uint8_t max_length = (capacity < MAX_V_BYTES) ? capacity : MAX_V_BYTES;
+  uint8_t *data;
+  uint8_t length = 0;
+
+  if (max_length < ENVELOPE_BYTES + IDM_BYTES + HASH_SIZE + VERSION_BYTES) {
+    return 0;
+  }
+  data = (uint8_t *)&url_buffer[(max_length + 2) / 3];
 
   /* 64 bit station id */
-  eeprom_read_station_info(&data[length], station_key);
+  if (!has_station_info) {
+    load_station_info();
+  }
+  memcpy(&data[length], station_id, STATION_ID_BYTES);
   length += STATION_ID_BYTES;
 
   /* 32 bit counter */
-  do {
-    uint32_t counter;
-    eeprom_increment_counter(&counter);
-    memcpy(&data[length], &counter, sizeof(counter));
-    length += sizeof(counter);
-  } while (0);
+  uint32_t url_counter;
+  eeprom_increment_counter(&url_counter);
+  memcpy(&data[length], &url_counter, sizeof(url_counter));
+  length += sizeof(url_counter);
 
   /* 64 bit felica id */
   if (idm != NULL) {
@@ -101,56 +331,147 @@ static bool __build_v_param(char *url_buffer, size_t url_buffer_size,
   }
   length += IDM_BYTES;
 
-  /* arbitrary data */
-  do {
-    uint8_t *tmpp = &data[length];
-    uint8_t *end = &data[length + MAX_ARBITRARY_SIZE];
-    __fill_proto(&tmpp, end);
-    length += (tmpp - &data[length]);
-  } while(0);
+  /* arbitrary data, leaving room for checksum and version */
+  length += url_arbitrary_data(&data[length],
+      max_length - HASH_SIZE - VERSION_BYTES - length, url_counter);
 
-  /* 64 bit sha1 hash */
+  /* 64 bit checksum */
+#if URL_VERSION == 2
   hash64(&data[length], data, length);
+#else
+  mac64(&data[length], data, length);
+#endif
   length += HASH_SIZE;
 
-  /* AES128-CTR */
-  do {
-    uint8_t counter[16];
-    /* envelope: station id + counter at the beginning */
-    uint8_t envelope_length = (64 + 32) / 8;
-    memset(counter, 0, sizeof(counter));
-    memcpy(counter, data, envelope_length);
-    enc128_ctr(&data[envelope_length], length - envelope_length,
-               station_key, counter);
-  } while (0);
+  /* AES128-CTR, with the precomputed keystream if it is current */
+  if (has_keystream && keystream_counter == url_counter) {
+    uint8_t i;
+    for (i = 0; i < length - ENVELOPE_BYTES; i++) {
+      data[ENVELOPE_BYTES + i] ^= keystream[i];
+    }
+    has_keystream = false;
+  } else {
+    uint8_t counter[BLOCK_SIZE];
+    __counter_block(counter, url_counter);
+    enc128_ctr(&data[ENVELOPE_BYTES], length - ENVELOPE_BYTES, counter);
+  }
 
   /* AES128 counter */
-  enc128(&data[STATION_ID_BYTES], station_key);
+  enc128(&data[STATION_ID_BYTES]);
 
   /* version */
-  memcpy(&data[length], &version, sizeof(version));
-  length += sizeof(version);
+  data[length++] = version;
 
-  return websafe_base64_encode(url_buffer, url_buffer_size, data, length);
+  if (param != NULL) {
+    memcpy(param, data, length);
+    *param_length = length;
+  }
+
+  if (!websafe_base64_encode(url_buffer, url_buffer_size, data, length)) {
+    return 0;
+  }
+  return (length * 4 + 2) / 3;
 }
 #endif /* WITHOUT_V_FIELD */
 
 /*
- * Build URL and store in supplied buffer.
- * Returns true on success.
+ * Build URL, without its first skip characters, and store in supplied
+ * buffer, null terminated.
+ * Returns the length stored, 0 on error.
  */
-bool build_url(char *url_buffer, size_t url_buffer_size,
-               uint8_t __attribute__((unused)) *idm)
+static uint8_t __build_url(char *url_buffer, size_t url_buffer_size,
+                           uint8_t __attribute__((unused)) *idm,
+                           uint8_t skip,
+                           uint8_t __attribute__((unused)) param[],
+                           uint8_t *param_length)
 {
+  uint8_t v_length = 0;
+  uint8_t prefix_length;
+
+  if (param_length != NULL) {
+    *param_length = 0;
+  }
+
+  if (skip > sizeof(URL) - 1)
+    return 0;
+  prefix_length = sizeof(URL) - 1 - skip;
+
   /* check for enough buffer space */
-  if (url_buffer_size <= sizeof(URL))
-    return false;
+  if (url_buffer_size <= (size_t)prefix_length + 1)
+    return 0;
 
-  memcpy(url_buffer, URL, sizeof(URL));
+  memcpy(url_buffer, &URL[skip], prefix_length + 1);
 
-  return __build_v_param(&url_buffer[sizeof(URL) - 1],
-                         url_buffer_size - sizeof(URL),
-                         idm, URL_VERSION);
+#ifndef WITHOUT_V_FIELD
+  v_length = __build_v_param(&url_buffer[prefix_length],
+                             url_buffer_size - prefix_length,
+                             idm, URL_VERSION, param, param_length);
+  if (v_length == 0)
+    return 0;
+#endif /* !WITHOUT_V_FIELD */
+
+  return prefix_length + v_length;
+}
+
+uint8_t build_url(char *url_buffer, size_t url_buffer_size, uint8_t *idm)
+{
+  return build_url_param(url_buffer, url_buffer_size, idm, NULL, NULL);
+}
+
+/*
+ * Build URL like build_url, leaving out its first skip characters so a
+ * caller that abbreviates the prefix can build the rest in place.
+ */
+uint8_t build_url_tail(char *url_buffer, size_t url_buffer_size,
+                       uint8_t *idm, uint8_t skip)
+{
+  uint8_t len;
+
+  trace(TRACE_URL_BUILD, 0);
+  len = __build_url(url_buffer, url_buffer_size, idm, skip, NULL, NULL);
+  trace(TRACE_URL_BUILT, len);
+  return len;
+}
+
+/*
+ * Build URL like build_url and copy its raw v parameter, before base64
+ * encoding, to param. param holds URL_PARAM_BYTES; param_length is set
+ * to the bytes copied.
+ */
+uint8_t build_url_param(char *url_buffer, size_t url_buffer_size,
+                        uint8_t *idm, uint8_t param[], uint8_t *param_length)
+{
+  uint8_t len;
+
+  trace(TRACE_URL_BUILD, 0);
+  len = __build_url(url_buffer, url_buffer_size, idm, 0,
+                    param, param_length);
+  trace(TRACE_URL_BUILT, len);
+  return len;
+}
+
+/*
+ * Build the URL again from a raw v parameter kept by build_url_param.
+ * Nothing is encrypted, the URL keeps its counter.
+ * Returns the length of the URL, 0 on error.
+ */
+uint8_t rebuild_url(char *url_buffer, size_t url_buffer_size,
+                    const uint8_t param[], uint8_t param_length)
+{
+  uint8_t v_length = (param_length * 4 + 2) / 3;
+  uint8_t len = 0;
+
+  trace(TRACE_URL_BUILD, 1);
+  if (url_buffer_size > sizeof(URL) - 1 + v_length) {
+    memcpy(url_buffer, URL, sizeof(URL));
+    if (websafe_base64_encode(&url_buffer[sizeof(URL) - 1],
+                              url_buffer_size - (sizeof(URL) - 1),
+                              param, param_length)) {
+      len = sizeof(URL) - 1 + v_length;
+    }
+  }
+  trace(TRACE_URL_BUILT, len);
+  return len;
 }
 
 /*
@@ -158,5 +479,22 @@ bool build_url(char *url_buffer, size_t url_buffer_size,
  */
 void set_extra_url_data(uint8_t voltage)
 {
-  battery_voltage = voltage;
+  if (voltage != battery_voltage) {
+    battery_voltage = voltage;
+    proto_changed = true;
+  }
+}
+
+/*
+ * Set the polling schedule to be transmitted with the URL.
+ */
+void set_poll_url_data(uint16_t interval_ms, uint8_t target_retry)
+{
+  if (!has_poll_data || interval_ms != poll_interval_ms ||
+      target_retry != target_mode_retry) {
+    poll_interval_ms = interval_ms;
+    target_mode_retry = target_retry;
+    has_poll_data = true;
+    proto_changed = true;
+  }
 }
@@ -33,13 +33,44 @@
 #define COUNTER_BYTES 4
 #define VERSION_BYTES 1
 #define STATION_KEY_BYTES 16
-#define URL_VERSION 2
+#ifndef URL_VERSION
+#define URL_VERSION 3 /* 2: SHA-1 checksum, 3: AES-CMAC checksum */
+#endif
 #define URL_LENGTH 128
+#define URL_PARAM_BYTES 57 /* longest raw v parameter, before base64 */
 
-/* build URL */
-bool build_url(char *url_buffer, size_t url_buffer_size, uint8_t *idm);
+/* read station id and expand station key; again after provisioning */
+void load_station_info(void);
+
+/* prepare the encryption of the next URL while idle */
+void precompute_url(void);
+
+/* build URL, returns its length or 0 on error */
+uint8_t build_url(char *url_buffer, size_t url_buffer_size, uint8_t *idm);
+
+/* build URL without its first skip characters, returns the length built */
+uint8_t build_url_tail(char *url_buffer, size_t url_buffer_size,
+                       uint8_t *idm, uint8_t skip);
+
+/* build URL and keep its raw v parameter, of up to URL_PARAM_BYTES */
+uint8_t build_url_param(char *url_buffer, size_t url_buffer_size,
+                        uint8_t *idm, uint8_t param[], uint8_t *param_length);
+
+/* build URL from a raw v parameter kept by build_url_param */
+uint8_t rebuild_url(char *url_buffer, size_t url_buffer_size,
+                    const uint8_t param[], uint8_t param_length);
+
+/* station info sent with the URL, as serialized proto */
+uint8_t url_station_info(uint8_t buf[], uint8_t size);
+
+/* arbitrary data of the URL with counter url_counter: station info and
+   one latency histogram, whose room is reserved first */
+uint8_t url_arbitrary_data(uint8_t buf[], uint8_t size, uint32_t url_counter);
 
 /* set extra data to be transmitted as part of URL */
 void set_extra_url_data(uint8_t voltage);
 
+/* set polling schedule to be transmitted as part of URL */
+void set_poll_url_data(uint16_t interval_ms, uint8_t target_retry);
+
 #endif /* __GENERATE_URL_H__ */
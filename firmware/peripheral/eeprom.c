@@ -23,11 +23,12 @@
 #include <string.h>
 
 #include "eeprom.h"
+#include "eeprom_queue.h"
 
 
 /*
  * Increments a specified uint32_t counter stored in EEPROM, and returns new
- * counter value.
+ * counter value. The write is queued, see eeprom_queue.h.
  *
  * Returns: new counter value.
  */
@@ -39,6 +40,7 @@ uint32_t increment_eeprom_uint32(uint32_t *pointer_eeprom)
     uint8_t u8[sizeof(uint32_t)];
   } counter;
 
+  eeprom_queue_flush();
   eeprom_read_block(&counter.u32, pointer_eeprom, sizeof(uint32_t));
 
   /*
@@ -52,6 +54,6 @@ uint32_t increment_eeprom_uint32(uint32_t *pointer_eeprom)
       break;
   }
   /* Write only as many bytes as actually changed */
-  eeprom_write_block(&counter.u32, (uint8_t*)pointer_eeprom, digit);
+  eeprom_queue_write(pointer_eeprom, &counter.u32, digit);
   return counter.u32;
 }
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Non-blocking EEPROM writes from the EEPROM ready interrupt. Bytes that
+ * already hold the queued value are skipped.
+ */
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "eeprom_queue.h"
+
+static uint8_t *__queue_addr[EEPROM_QUEUE_SIZE];
+static uint8_t __queue_data[EEPROM_QUEUE_SIZE];
+static volatile uint8_t __queue_write_index;
+static volatile uint8_t __queue_read_index;
+static volatile bool __queue_busy;
+static uint16_t __queue_park;
+
+/*
+ * Starts programming the next queued byte that differs from EEPROM.
+ * Call only while no byte is programmed.
+ */
+static void __program_next(void)
+{
+  while (__queue_read_index != __queue_write_index) {
+    uint8_t i = __queue_read_index++ & (EEPROM_QUEUE_SIZE - 1);
+
+    EEAR = (uint16_t)__queue_addr[i];
+    EECR |= _BV(EERE);
+    if (EEDR != __queue_data[i]) {
+      EEDR = __queue_data[i];
+      EECR |= _BV(EEMPE);
+      EECR |= _BV(EEPE);
+      return;
+    }
+  }
+  // Put EEAR back where it was, see eeprom_has_station_info()
+  EEAR = __queue_park;
+  EECR &= ~_BV(EERIE);
+  __queue_busy = false;
+}
+
+ISR(EE_READY_vect)
+{
+  __program_next();
+}
+
+/*
+ * Waits for the EEPROM ready interrupt. With interrupts disabled, as in
+ * reset_mcusr(), polls for it instead.
+ */
+static void __wait(void)
+{
+  if (!(SREG & _BV(SREG_I)) && !(EECR & _BV(EEPE))) {
+    __program_next();
+  }
+}
+
+void eeprom_queue_init(void)
+{
+  __queue_write_index = __queue_read_index = 0;
+  __queue_busy = false;
+}
+
+/*
+ * Queues bytes for the EEPROM ready interrupt. Waits if the queue is full.
+ */
+void eeprom_queue_write(void *dst, const void *src, uint8_t len)
+{
+  uint8_t *to = dst;
+  const uint8_t *from = src;
+
+  while (len--) {
+    uint8_t sreg;
+
+    while ((uint8_t)(__queue_write_index - __queue_read_index)
+           >= EEPROM_QUEUE_SIZE) {
+      __wait();
+    }
+    sreg = SREG;
+    cli();
+    if (!__queue_busy) {
+      __queue_park = EEAR;
+      __queue_busy = true;
+    }
+    __queue_addr[__queue_write_index & (EEPROM_QUEUE_SIZE - 1)] = to++;
+    __queue_data[__queue_write_index & (EEPROM_QUEUE_SIZE - 1)] = *from++;
+    __queue_write_index++;
+    EECR |= _BV(EERIE);
+    SREG = sreg;
+  }
+}
+
+bool eeprom_queue_pending(void)
+{
+  return __queue_busy;
+}
+
+/*
+ * Busy waits: the EEPROM ready interrupt does not wake up from sleep
+ * modes other than idle, and is disabled once the queue is empty.
+ */
+void eeprom_queue_flush(void)
+{
+  while (__queue_busy) {
+    __wait();
+  }
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Non-blocking EEPROM writes. Bytes are queued in RAM and programmed one
+ * at a time from the EEPROM ready interrupt, so the caller does not wait
+ * the 3.3 ms each byte takes.
+ */
+
+#ifndef __EEPROM_QUEUE_H__
+#define __EEPROM_QUEUE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Must be a power of 2
+#ifndef EEPROM_QUEUE_SIZE
+#define EEPROM_QUEUE_SIZE 8
+#endif
+
+// Empties the queue. Needed only before .bss is cleared (.init3).
+void eeprom_queue_init(void);
+
+// Queues len bytes for writing to EEPROM address dst. Waits for room if
+// the queue is full.
+void eeprom_queue_write(void *dst, const void *src, uint8_t len);
+
+// Returns true until all queued bytes are programmed.
+bool eeprom_queue_pending(void);
+
+// Waits until all queued bytes are programmed. Call before any other
+// EEPROM access, the EEPROM cannot be read while it is programmed.
+void eeprom_queue_flush(void);
+
+#endif /* __EEPROM_QUEUE_H__ */
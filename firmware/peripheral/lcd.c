@@ -43,6 +43,9 @@
 // The character buffer
 static char __buf[LINE_LEN*MAX_LINE+1];
 
+// Lines changed in the buffer but not on the LCD yet
+static uint8_t __dirty;
+
 /*
  * Sends one nibble (4 bits) to the LCD.
  */
@@ -150,6 +153,23 @@ static void __update_lcd_line(uint8_t line)
   }
 }
 
+/*
+ * Copies changed lines to the LCD, about 1 ms per line. Printing only
+ * writes to the buffer, so call this when there is time, e.g. before
+ * sleeping, instead of in the middle of an exchange with a phone.
+ */
+void lcd_update(void)
+{
+  uint8_t line;
+
+  for (line = 0; line < MAX_LINE; line++) {
+    if (__dirty & (1 << line)) {
+      __update_lcd_line(line);
+    }
+  }
+  __dirty = 0;
+}
+
 /*
  * Print null terminated string to start of line and clear rest of the line.
  */
@@ -172,7 +192,7 @@ void lcd_puts2(uint8_t line, uint8_t pos, char* text)
   while (i < LINE_LEN) {
     BUF(line, i++) = ' ';
   }
-  __update_lcd_line(line);
+  __dirty |= 1 << line;
 }
 
 /*
@@ -187,7 +207,7 @@ void lcd_printf(uint8_t line, char* format, ...)
   while (i < LINE_LEN) {
     BUF(line, i++) = ' ';
   }
-  __update_lcd_line(line);
+  __dirty |= 1 << line;
 }
 
 /*
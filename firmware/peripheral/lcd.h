@@ -41,6 +41,9 @@
 /* Initializes display. */
 void lcd_init(void);
 
+/* Copies lines printed since the last update to the display */
+void lcd_update(void);
+
 /* Prints null terminated string to specified line */
 void lcd_puts(uint8_t line, char* text);
 
@@ -55,6 +58,7 @@ void lcd_print_hex(uint8_t line, uint8_t* data, uint8_t len);
 
 #else /* !HAS_LCD */
 #define lcd_init()
+#define lcd_update()
 #define lcd_puts(X, Y)
 #define lcd_puts2(X, Y, Z)
 #define lcd_print_hex(X, Y, Z)
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Debug messages with compile-time levels, shown on the LCD in HAS_LCD
+ * builds. Messages above LOG_LEVEL compile to nothing, so a debug build
+ * can keep the failures and touch results without formatting strings in
+ * the middle of an exchange with a phone.
+ */
+
+#ifndef __LOG_H__
+#define __LOG_H__
+
+#include "lcd.h"
+
+#define LOG_NONE 0
+#define LOG_ERROR 1  // Something failed
+#define LOG_INFO 2  // Result of a touch, state of the station
+#define LOG_DEBUG 3  // Steps of a protocol exchange
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_INFO
+#endif
+
+#define log_printf(level, line, ...) \
+  do { \
+    if ((level) <= LOG_LEVEL) { \
+      lcd_printf((line), __VA_ARGS__); \
+    } \
+  } while (0)
+
+#define log_puts(level, line, text) \
+  do { \
+    if ((level) <= LOG_LEVEL) { \
+      lcd_puts((line), (text)); \
+    } \
+  } while (0)
+
+#define log_hex(level, line, data, len) \
+  do { \
+    if ((level) <= LOG_LEVEL) { \
+      lcd_print_hex((line), (data), (len)); \
+    } \
+  } while (0)
+
+#endif /* __LOG_H__ */
@@ -21,12 +21,15 @@
  * so chip actually stays asleep.
  */
 
+#include <stddef.h>
+
 #include <avr/interrupt.h>
 #include <avr/io.h>
 #include <avr/power.h>
 #include <avr/sleep.h>
 #include <avr/wdt.h>
 
+#include "eeprom_queue.h"
 #include "power_down.h"
 
 /*
@@ -39,20 +42,37 @@ void disable_unused_circuits()
 }
 
 /*
- * Goes into specified sleep mode. Be sure to configure a wake-up
+ * Goes into specified sleep mode unless awake, if not NULL, returns true.
+ * awake is checked with interrupts off, so a wake-up interrupt right after
+ * the check still ends the sleep. Be sure to configure a wake-up
  * condition, otherwise only a power reset can wake the chip up.
+ * Returns true if it slept.
  */
-static void __sleep(uint8_t mode)
+static bool __sleep_unless(uint8_t mode, bool (*awake)(void))
 {
+  // Queued EEPROM writes only continue from idle mode
+  if (mode != SLEEP_MODE_IDLE) {
+    eeprom_queue_flush();
+  }
   set_sleep_mode(mode);
   // disable brown-out to save power and sleep
   cli();
+  if (awake != NULL && awake()) {
+    sei();
+    return false;
+  }
   sleep_enable();
   sleep_bod_disable();
   // Make sure we can wake up
   sei();
   sleep_cpu();
   sleep_disable();
+  return true;
+}
+
+static void __sleep(uint8_t mode)
+{
+  (void)__sleep_unless(mode, NULL);
 }
 
 /*
@@ -109,14 +129,27 @@ void sleep_until_timer(uint8_t mode, bool clock_down)
  */
 void sleep_forever()
 {
+  (void)sleep_forever_unless(NULL);
+}
+
+/*
+ * Sleeps like sleep_forever unless awake returns true, checked with
+ * interrupts off so that the wake-up interrupt cannot slip in between.
+ * Returns true if it slept.
+ */
+bool sleep_forever_unless(bool (*awake)(void))
+{
+  bool slept;
+
   // Preserve original power settings
   uint8_t power_reduction = PRR;
   PRR = 0xFF;  // turn off all peripherals
 
-  __sleep(SLEEP_MODE_PWR_DOWN);
+  slept = __sleep_unless(SLEEP_MODE_PWR_DOWN, awake);
 
   // Restore previous power settings
   PRR = power_reduction;
+  return slept;
 }
 
 /*
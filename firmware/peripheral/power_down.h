@@ -22,14 +22,19 @@
 #define __POWER_DOWN_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 
 // Use this to compute how many times to call sleep_until_timer, passing
 // the desired duration in milliseconds. This avoids floating point computation
 // at runtime.
 // The macro rounds up, i.e. actual sleep time may be longer than
 // the specified value in ms.
-#define SLEEP_COUNT_CLK_DOWN(x) ((x - 1) / (8 * 1024L * 255 * 1000 / F_CPU)) + 1
-#define SLEEP_COUNT(x) ((x - 1) / (1024L * 255 * 1000 / F_CPU)) + 1
+#define SLEEP_COUNT_CLK_DOWN(x) ((x - 1) / SLEEP_MS_CLK_DOWN) + 1
+#define SLEEP_COUNT(x) ((x - 1) / SLEEP_MS) + 1
+
+// Milliseconds slept by one sleep_until_timer call, rounded down.
+#define SLEEP_MS (1024L * 255 * 1000 / F_CPU)
+#define SLEEP_MS_CLK_DOWN (8 * 1024L * 255 * 1000 / F_CPU)
 
 // Disable AVR modules not being used to save power
 void disable_unused_circuits();
@@ -40,6 +45,9 @@ void sleep_until_timer(uint8_t mode, bool clock_down);
 // Sleep AVR in lowest power state (set wake-up condition before!).
 void sleep_forever();
 
+// Same unless awake() is true, checked with interrupts off
+bool sleep_forever_unless(bool (*awake)(void));
+
 // Configures AVR to wake up when PCINT1 goes low
 void wakeup_on_external_interrupt(void);
 
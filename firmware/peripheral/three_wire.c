@@ -23,6 +23,7 @@
 #include <util/delay.h>
 
 #include "three_wire.h"
+#include "three_wire_timing.h"
 
 /*
  * Configure serial IO
@@ -127,23 +128,17 @@ void twspi_end_send(void)
 
 /*
  * Sends a single byte to the bus, MSB first.
- * Max specified bus speed is 1 MHz.
+ * Max specified bus speed is 1 MHz; the unrolled sequence runs at
+ * 9 cycles per bit (see three_wire_timing.h).
  */
 void twspi_send(uint8_t c)
 {
-  uint8_t i = 8;
-  do {
-    TWSPI_PORT &= ~_BV(TWSPI_CLK);
-    if (c & 0x80) {
-      TWSPI_PORT |= _BV(TWSPI_DATA);
-    } else {
-      TWSPI_PORT &= ~_BV(TWSPI_DATA);
-    }
-    c <<= 1;
-    _delay_us(1);
-    TWSPI_PORT |= _BV(TWSPI_CLK);
-    _delay_us(1);
-  } while (--i);
+  asm volatile (TWSPI_SEND_BYTE
+                :
+                : [c] "r" (c),
+                  [port] "I" (_SFR_IO_ADDR(TWSPI_PORT)),
+                  [clk] "I" (TWSPI_CLK),
+                  [data] "I" (TWSPI_DATA));
 }
 
 /*
@@ -168,18 +163,14 @@ void twspi_send_buf_p(const prog_char *buf, uint8_t len)
  */
 uint8_t twspi_get(void)
 {
-  uint8_t data = 0;
-
-  for (uint8_t i = 0; i < 8; i++) {
-    TWSPI_PORT &= ~_BV(TWSPI_CLK);
-    _delay_us(1);
-    data <<= 1;
-    if (TWSPI_PIN & _BV(TWSPI_DATA)) {
-      data |= 1;
-    }
-    TWSPI_PORT |= _BV(TWSPI_CLK);
-    _delay_us(1);
-  }
+  uint8_t data;
+
+  asm volatile (TWSPI_GET_BYTE
+                : [d] "=&d" (data)
+                : [port] "I" (_SFR_IO_ADDR(TWSPI_PORT)),
+                  [pin] "I" (_SFR_IO_ADDR(TWSPI_PIN)),
+                  [clk] "I" (TWSPI_CLK),
+                  [data] "I" (TWSPI_DATA));
   return data;
 }
 
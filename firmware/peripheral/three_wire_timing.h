@@ -0,0 +1,66 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Bit timing of the Felica Plug three-wire bus and the instruction
+ * sequences twspi_send() and twspi_get() are built from. The sequences
+ * are plain strings so that test/three_wire_test.c can run them through
+ * a cycle model of the bus and check them against the limits below.
+ */
+
+#ifndef __THREE_WIRE_TIMING__H__
+#define __THREE_WIRE_TIMING__H__
+
+// Bus limits the driver has to meet (1 MHz maximum clock).
+#define TWSPI_CLK_LOW_MIN_NS 500
+#define TWSPI_CLK_HIGH_MIN_NS 500
+#define TWSPI_SETUP_MIN_NS 100  // DATA stable before CLK rises
+#define TWSPI_HOLD_MIN_NS 100  // DATA stable after CLK rises
+#define TWSPI_ACCESS_MAX_NS 500  // DATA valid from plug after CLK falls
+
+// One bit to the plug. DATA changes while CLK is low and is sampled on
+// the rising edge. Together the two skip pairs take 5 cycles whatever the
+// bit value, so every bit is 9 cycles.
+#define TWSPI_SEND_BIT(b)                       \
+  "cbi %[port], %[clk]\n\t"                     \
+  "sbrc %[c], " #b "\n\t"                       \
+  "sbi %[port], %[data]\n\t"                    \
+  "sbrs %[c], " #b "\n\t"                       \
+  "cbi %[port], %[data]\n\t"                    \
+  "sbi %[port], %[clk]\n\t"
+
+#define TWSPI_SEND_BYTE                                         \
+  TWSPI_SEND_BIT(7) TWSPI_SEND_BIT(6) TWSPI_SEND_BIT(5)         \
+  TWSPI_SEND_BIT(4) TWSPI_SEND_BIT(3) TWSPI_SEND_BIT(2)         \
+  TWSPI_SEND_BIT(1) TWSPI_SEND_BIT(0)
+
+// One bit from the plug. The plug shifts out the next bit on the falling
+// edge; the nops cover its access time plus the input synchronizer.
+#define TWSPI_GET_BIT(mask)                     \
+  "cbi %[port], %[clk]\n\t"                     \
+  "nop\n\t"                                     \
+  "nop\n\t"                                     \
+  "nop\n\t"                                     \
+  "nop\n\t"                                     \
+  "sbic %[pin], %[data]\n\t"                    \
+  "ori %[d], " #mask "\n\t"                     \
+  "sbi %[port], %[clk]\n\t"
+
+#define TWSPI_GET_BYTE                                          \
+  "clr %[d]\n\t"                                                \
+  TWSPI_GET_BIT(0x80) TWSPI_GET_BIT(0x40) TWSPI_GET_BIT(0x20)   \
+  TWSPI_GET_BIT(0x10) TWSPI_GET_BIT(0x08) TWSPI_GET_BIT(0x04)   \
+  TWSPI_GET_BIT(0x02) TWSPI_GET_BIT(0x01)
+
+#endif /*__THREE_WIRE_TIMING__H__ */
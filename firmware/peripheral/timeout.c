@@ -0,0 +1,83 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * One-shot millisecond timeouts that run while the CPU sleeps, so waiting
+ * code can sleep in idle mode instead of counting calibrated delays.
+ *
+ * Uses 8 bit Timer/Counter 2 in CTC mode with a 1 ms period. Timer 2 also
+ * wakes up sleep_until_timer, so the two must not be used at the same time.
+ */
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "timeout.h"
+
+/* Timer 2 ticks per ms at clk/128: 28 (1.001 ms) at 3.58MHz */
+#define TICKS_PER_MS ((F_CPU + 64000) / 128000)
+
+#if TICKS_PER_MS > 256
+  #error "Not supported frequency"
+#endif
+
+static volatile uint16_t __timeout_ms;
+static volatile bool __timeout_expired;
+
+ISR(TIMER2_COMPA_vect)
+{
+  if (--__timeout_ms == 0) {
+    TCCR2B = 0;  // Stop counter
+    __timeout_expired = true;
+  }
+}
+
+/*
+ * Starts a timeout of ms milliseconds. A running timeout is restarted.
+ */
+void timeout_start(uint16_t ms)
+{
+  TCCR2B = 0;  // Stop timer while we setup
+  TIMSK2 = 0;
+  __timeout_ms = ms;
+  __timeout_expired = (ms == 0);
+  if (ms == 0)
+    return;
+
+  TCNT2 = 0;
+  OCR2A = TICKS_PER_MS - 1;
+  TCCR2A = _BV(WGM21);  // CTC mode
+  TIFR2 = _BV(OCF2A);  // Clear a stale match
+  TIMSK2 = _BV(OCIE2A);  // Match interrupt enable
+  sei();
+  TCCR2B = _BV(CS22) | _BV(CS20);  // Clock = Fcpu/128
+}
+
+/*
+ * Returns true once the timeout has expired.
+ */
+bool timeout_expired(void)
+{
+  return __timeout_expired;
+}
+
+/*
+ * Stops the timer and returns it to normal mode for sleep_until_timer.
+ */
+void timeout_stop(void)
+{
+  TCCR2B = 0;
+  TIMSK2 &= ~_BV(OCIE2A);
+  TCCR2A = 0;
+}
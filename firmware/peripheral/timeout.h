@@ -0,0 +1,35 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * One-shot millisecond timeouts that run while the CPU sleeps.
+ * Uses 8 bit Timer/Counter 2, shared with sleep_until_timer.
+ */
+
+#ifndef TIMEOUT_H_
+#define TIMEOUT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Starts a timeout of ms milliseconds. Interrupts wake the CPU every ms.
+void timeout_start(uint16_t ms);
+
+// Returns true once the timeout has expired.
+bool timeout_expired(void);
+
+// Stops the timer, expired or not.
+void timeout_stop(void);
+
+#endif  // TIMEOUT_H_
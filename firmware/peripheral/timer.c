@@ -18,7 +18,8 @@
  * Values are approximate. Interrupt handling (minimally) slows processing,
  * about 20 clock cycles per interrupt.
  *
- * Uses 16 bit Timer/Counter 1
+ * Uses 16 bit Timer/Counter 1. In WITH_TRACE builds it runs free as the
+ * trace clock, and timers are read from it instead.
  */
 
 #include <stdbool.h>
@@ -28,6 +29,49 @@
 
 #include "timer.h"
 
+#ifdef WITH_TRACE
+static uint16_t started;
+static uint16_t stopped;
+static bool running = false;
+static enum TIMER_RESOLUTION unit;
+
+/*
+ * Starts timing from the trace clock, which keeps running.
+ */
+void start_timer(enum TIMER_RESOLUTION resolution)
+{
+  unit = resolution;
+  started = trace_clock();
+  running = true;
+}
+
+/*
+ * Returns the number of time units passed since start_timer, in steps of
+ * TRACE_CLOCK_PRESCALER cycles.
+ */
+unsigned int get_timer()
+{
+  uint32_t cycles = (uint16_t)((running ? trace_clock() : stopped) - started);
+
+  cycles *= TRACE_CLOCK_PRESCALER;
+  if (unit == TIMER_RES_CLOCK)
+    return cycles;
+  else
+    return cycles / (unit - 30);  // without the interrupt compensation
+}
+
+/*
+ * Stops the timer. The last timer value is preserved.
+ */
+void stop_timer()
+{
+  if (running) {
+    stopped = trace_clock();
+    running = false;
+  }
+}
+
+#else /* !WITH_TRACE */
 static unsigned int counter = 0;
 static bool raw = false;
 
@@ -77,3 +121,21 @@ void stop_timer()
   // Disable interrupt in case another module uses the timer
   TIMSK1 &= ~_BV(OCIE1A);
 }
+#endif /* WITH_TRACE */
+
+/*
+ * Returns Timer 1 running free at CLK/TRACE_CLOCK_PRESCALER, restarting
+ * it that way if start_timer has taken it over.
+ */
+uint16_t trace_clock(void)
+{
+  const uint8_t mode = _BV(WGM13) | _BV(WGM12)
+                       | _BV(CS12) | _BV(CS11) | _BV(CS10);
+
+  if ((TCCR1B & mode) != _BV(CS12)) {  // normal mode, CLK/256
+    TIMSK1 &= ~_BV(OCIE1A);
+    TCCR1A = 0;
+    TCCR1B = _BV(CS12);
+  }
+  return TCNT1;
+}
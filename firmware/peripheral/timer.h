@@ -15,12 +15,15 @@
  * limitations under the License.
  *
  * Simple background timing for debugging and testing. Timers cannot nest.
- * Uses 16 bit Timer/Counter 1.
+ * Uses 16 bit Timer/Counter 1, which runs free as the trace clock in
+ * WITH_TRACE builds.
  */
 
 #ifndef TIMER_H_
 #define TIMER_H_
 
+#include <stdint.h>
+
 // Set the timer slower to compensate for additional run-time due to
 // counter interrupt (est. 30 clock cycles).
 enum TIMER_RESOLUTION {
@@ -38,4 +41,11 @@ unsigned int get_timer();
 // Stops the timer. The last timer value is preserved.
 void stop_timer();
 
+// Timer 1 prescaler of the trace clock
+#define TRACE_CLOCK_PRESCALER 256
+
+// Returns the free-running trace clock, one tick per TRACE_CLOCK_PRESCALER
+// CPU cycles. Starts it on first use. Wraps after about 4.7s at 3.58MHz.
+uint16_t trace_clock(void);
+
 #endif  // TIMER_H_
@@ -15,10 +15,13 @@
  *
  * Read and write using built-in USART.
  *
- * Uses synchronous send and asynchronous (interrupt-driven) receive.
+ * Uses asynchronous (interrupt-driven) send and receive. Sent bytes are
+ * queued in a ring buffer drained by the data register empty interrupt.
  * Does not check for receive buffer overflow.
  */
 
+#include <stddef.h>
+
 #include <avr/interrupt.h>
 #include <avr/io.h>
 #include <avr/sleep.h>
@@ -28,6 +31,12 @@
 static volatile uint8_t __usart_buffer[RECEIVE_BUFFER_SIZE];
 static volatile uint8_t __usart_buffer_write_index;
 static uint8_t __usart_buffer_read_index;
+static usart_receive_handler __usart_handler;
+
+static uint8_t __usart_tx_buffer[TRANSMIT_BUFFER_SIZE];
+static volatile uint8_t __usart_tx_write_index;
+static volatile uint8_t __usart_tx_read_index;
+static bool __usart_tx_started;
 
 /*
  * Configure serial IO
@@ -58,6 +67,9 @@ void usart_init(void)
   /* 8 data bits, no parity, 1 stop bit */
   UCSR0C = (3 << UCSZ00);
 
+  __usart_tx_write_index = __usart_tx_read_index = 0;
+  __usart_tx_started = false;
+
   sei();
 }
 
@@ -66,6 +78,7 @@ void usart_init(void)
  */
 void usart_disable(void)
 {
+  usart_flush();
   UCSR0B = 0;
   DDRD &= ~(PORTD0 | PORTD1);
 }
@@ -99,22 +112,88 @@ ISR(USART0_RX_vect)
 ISR(USART_RX_vect)
 #endif
 {
-  __usart_buffer[__usart_buffer_write_index++ & (RECEIVE_BUFFER_SIZE - 1)]
-      = UDR0;
+  if (__usart_handler != NULL) {
+    __usart_handler(UDR0);
+  } else {
+    __usart_buffer[__usart_buffer_write_index++ & (RECEIVE_BUFFER_SIZE - 1)]
+        = UDR0;
+  }
 }
 
 /*
- * Sends one byte via USART. Waits in busy loop if not ready.
+ * Passes received bytes to handler, from the RX interrupt, instead of
+ * buffering them. Passing NULL goes back to the receive buffer.
+ */
+void usart_set_receive_handler(usart_receive_handler handler)
+{
+  uint8_t sreg = SREG;
+
+  cli();
+  __usart_handler = handler;
+  SREG = sreg;
+}
+
+#ifdef __atmega644p__
+ISR(USART0_UDRE_vect)
+#else
+ISR(USART_UDRE_vect)
+#endif
+{
+  if (__usart_tx_read_index == __usart_tx_write_index) {
+    UCSR0B &= ~_BV(UDRIE0);
+  } else {
+    /* Clear TXC0 (U2X0 and MPCM0 are never used); it is set again once
+     * this byte has been shifted out with nothing queued behind it. */
+    UCSR0A = _BV(TXC0);
+    UDR0 = __usart_tx_buffer[__usart_tx_read_index++
+        & (TRANSMIT_BUFFER_SIZE - 1)];
+  }
+}
+
+/*
+ * Queues one byte for sending via USART.
+ * Waits in idle mode if the transmit buffer is full.
  */
 void usart_send(uint8_t c)
 {
-  while (!(UCSR0A & (1 << UDRE0)))
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  while ((uint8_t)(__usart_tx_write_index - __usart_tx_read_index)
+         >= TRANSMIT_BUFFER_SIZE) {
+    sleep_mode();
+  }
+
+  __usart_tx_buffer[__usart_tx_write_index & (TRANSMIT_BUFFER_SIZE - 1)] = c;
+  __usart_tx_write_index++;
+  __usart_tx_started = true;
+  UCSR0B |= _BV(UDRIE0);
+}
+
+/*
+ * Returns true iff every queued byte, including its stop bit, has left
+ * the MCU.
+ */
+bool usart_send_done(void)
+{
+  return (__usart_tx_read_index == __usart_tx_write_index &&
+          (!__usart_tx_started || (UCSR0A & _BV(TXC0))));
+}
+
+/*
+ * Waits until every queued byte has left the MCU. Sleeps in idle mode
+ * while the buffer drains and busy-waits for the last byte.
+ */
+void usart_flush(void)
+{
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  while (__usart_tx_read_index != __usart_tx_write_index) {
+    sleep_mode();
+  }
+  while (!usart_send_done())
     ;
-  UDR0 = c;
 }
 
 /*
- * Sends a sequence of bytes via USART.
+ * Queues a sequence of bytes for sending via USART.
  */
 void usart_send_buf(const uint8_t* buf, int len)
 {
@@ -124,7 +203,7 @@ void usart_send_buf(const uint8_t* buf, int len)
 }
 
 /*
- * Sends a sequence of bytes from program memory via USART.
+ * Queues a sequence of bytes from program memory for sending via USART.
  */
 void usart_send_buf_p(const prog_char* buf, int len)
 {
@@ -138,7 +217,9 @@ void usart_send_buf_p(const prog_char* buf, int len)
  */
 void usart_clear_receive_buffer(void)
 {
+  uint8_t sreg = SREG;
+
   cli();
   __usart_buffer_write_index = __usart_buffer_read_index = 0;
-  sei();
+  SREG = sreg;
 }
@@ -15,7 +15,7 @@
  *
  * Read and write using built-in USART.
  *
- * Uses synchronous send and asynchronous (interrupt-driven) receive.
+ * Uses asynchronous (interrupt-driven) send and receive.
  * Does not check for receive buffer overflow.
  */
 
@@ -31,17 +31,30 @@
 /* At 115200baud we receive at most ~11bytes/ms */
 #define RECEIVE_BUFFER_SIZE 32
 
+/* Size of transmit data buffer (must be power of 2, at most 128) */
+/* Sending blocks only while the buffer is full */
+#define TRANSMIT_BUFFER_SIZE 64
+
 void usart_init(void);
 void usart_disable(void);
 void usart_clear_receive_buffer(void);
 
+// Called from the RX interrupt for each received byte
+typedef void (*usart_receive_handler)(uint8_t c);
+
+// Routes received bytes to handler instead of the buffer (NULL restores)
+void usart_set_receive_handler(usart_receive_handler handler);
+
 /* Receive (asynchronous) */
 bool usart_has_data(void);
 uint8_t usart_get(void);
 
-/* Send (synchronous) */
+/* Send (asynchronous) */
 void usart_send(uint8_t c);
 void usart_send_buf(const uint8_t* buf, int len);
 void usart_send_buf_p(const prog_char* buf,int len);
+// True once all queued bytes have left the MCU
+bool usart_send_done(void);
+void usart_flush(void);
 
 #endif /*__USART__H__ */
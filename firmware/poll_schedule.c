@@ -0,0 +1,145 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Adaptive polling duty cycle. Queues of users at a venue want the
+ * shortest interval, an idle station wants to save the battery.
+ *
+ * Polling modes are weighted by recent touch counts. The mode with
+ * more completed touches runs first and in every cycle, the other one
+ * in a share of cycles proportional to its count, but at least
+ * MODE_SHARE_MIN sixteenths so new kinds of phones are still served.
+ */
+
+#include "eeprom_data.h"
+
+#include "poll_schedule.h"
+
+// Whole share of cycles, in sixteenths
+#define SHARE_ALL 16
+
+static uint16_t interval_ms = POLL_INTERVAL_MIN_MS;
+static uint8_t idle_cycles;
+
+// Touch counts, halved whenever one would overflow to favor recent ones
+static uint8_t weights[NUM_TOUCH_KINDS];
+static uint8_t initiator_credit;
+static uint8_t target_credit;
+
+/*
+ * Resets the interval to the minimum after a touch. Once the station
+ * has been idle for POLL_BUSY_CYCLES, grows it by half plus
+ * POLL_INTERVAL_STEP_MS per cycle, up to POLL_INTERVAL_MAX_MS.
+ */
+void poll_schedule_update(bool touched)
+{
+  uint32_t next;
+
+  if (touched) {
+    idle_cycles = 0;
+    interval_ms = POLL_INTERVAL_MIN_MS;
+    return;
+  }
+  if (idle_cycles < POLL_BUSY_CYCLES) {
+    idle_cycles++;
+    return;
+  }
+  next = (uint32_t)interval_ms + interval_ms / 2 + POLL_INTERVAL_STEP_MS;
+  interval_ms = next < POLL_INTERVAL_MAX_MS ? next : POLL_INTERVAL_MAX_MS;
+}
+
+uint16_t poll_schedule_interval_ms(void)
+{
+  return interval_ms;
+}
+
+/*
+ * A busy station keeps trying target mode with a phone that is being
+ * held to it; an idle one gives up early on stray activations.
+ */
+uint8_t poll_schedule_target_retries(void)
+{
+  return idle_cycles < POLL_BUSY_CYCLES ? TARGET_RETRY_MAX : TARGET_RETRY_MIN;
+}
+
+void poll_schedule_load(void)
+{
+  eeprom_read_touch_weights(weights);
+}
+
+/*
+ * Touches are counted in RAM only; the weights are saved now and then
+ * to spare the EEPROM. A reset loses the touches since the last save.
+ */
+void poll_schedule_save(void)
+{
+  eeprom_write_touch_weights(weights);
+}
+
+void poll_schedule_touch(enum touch_kind kind)
+{
+  uint8_t i;
+
+  if (weights[kind] == 0xff) {
+    for (i = 0; i < NUM_TOUCH_KINDS; i++) {
+      weights[i] >>= 1;
+    }
+  }
+  weights[kind]++;
+}
+
+static uint16_t __target_weight(void)
+{
+  return (uint16_t)weights[TOUCH_SNEP] + weights[TOUCH_NPP]
+      + weights[TOUCH_TYPE3];
+}
+
+bool poll_schedule_target_first(void)
+{
+  return __target_weight() > weights[TOUCH_FELICA_PUSH];
+}
+
+/*
+ * Adds the share of a mode with the given weight to its credit and
+ * takes a whole cycle from it if there is one.
+ */
+static bool __due(uint8_t *credit, uint16_t weight)
+{
+  uint16_t max = __target_weight();
+  uint8_t share;
+
+  if (weights[TOUCH_FELICA_PUSH] > max) {
+    max = weights[TOUCH_FELICA_PUSH];
+  }
+  share = SHARE_ALL * (weight + 1) / (max + 1);
+  if (share < MODE_SHARE_MIN) {
+    share = MODE_SHARE_MIN;
+  }
+  *credit += share;
+  if (*credit < SHARE_ALL) {
+    return false;
+  }
+  *credit -= SHARE_ALL;
+  return true;
+}
+
+bool poll_schedule_run_initiator(void)
+{
+  return __due(&initiator_credit, weights[TOUCH_FELICA_PUSH]);
+}
+
+bool poll_schedule_run_target(void)
+{
+  return __due(&target_credit, __target_weight());
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Chooses the idle time between polling cycles from the touch history:
+ * short while phones keep coming, growing progressively when idle.
+ * Also weighs Felica push against target mode by what phones complete.
+ */
+
+#ifndef __POLL_SCHEDULE_H__
+#define __POLL_SCHEDULE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Bounds of the idle time between polling cycles. Target mode already
+// listens for an initiator between polls, so it may poll back to back.
+#ifndef POLL_INTERVAL_MIN_MS
+#ifdef WITH_TARGET
+#define POLL_INTERVAL_MIN_MS 0
+#else
+#define POLL_INTERVAL_MIN_MS 100
+#endif
+#endif
+#ifndef POLL_INTERVAL_MAX_MS
+#define POLL_INTERVAL_MAX_MS 2000
+#endif
+
+// Growth per idle cycle: half the interval plus this step
+#ifndef POLL_INTERVAL_STEP_MS
+#define POLL_INTERVAL_STEP_MS 50
+#endif
+
+// Cycles after a touch before the interval starts to grow
+#ifndef POLL_BUSY_CYCLES
+#define POLL_BUSY_CYCLES 20
+#endif
+
+// Bounds of the target mode retries after seeing an initiator
+#ifndef TARGET_RETRY_MIN
+#define TARGET_RETRY_MIN 3
+#endif
+#ifndef TARGET_RETRY_MAX
+#define TARGET_RETRY_MAX 10
+#endif
+
+// Share of cycles, in sixteenths, left to the less successful mode
+#ifndef MODE_SHARE_MIN
+#define MODE_SHARE_MIN 4
+#endif
+
+// Kinds of completed touches, counted to weigh the polling modes
+enum touch_kind {
+  TOUCH_FELICA_PUSH,  // URL pushed as initiator
+  TOUCH_SNEP,         // NDEF pushed over LLCP/SNEP as target
+  TOUCH_NPP,          // NDEF pushed over LLCP/NPP as target
+  TOUCH_TYPE3,        // Type 3 tag read as target
+  NUM_TOUCH_KINDS
+};
+
+// Records the outcome of one polling cycle.
+void poll_schedule_update(bool touched);
+
+// Idle time before the next polling cycle.
+uint16_t poll_schedule_interval_ms(void);
+
+// Number of target mode attempts after seeing an initiator.
+uint8_t poll_schedule_target_retries(void);
+
+// Loads the weights saved in EEPROM.
+void poll_schedule_load(void);
+
+// Saves the weights to EEPROM. Call rarely, e.g. hourly.
+void poll_schedule_save(void);
+
+// Counts a completed touch.
+void poll_schedule_touch(enum touch_kind kind);
+
+// True if target mode should come before the Felica push poll.
+bool poll_schedule_target_first(void);
+
+// Whether this cycle polls as initiator or waits as target. Each is
+// called once per cycle.
+bool poll_schedule_run_initiator(void);
+bool poll_schedule_run_target(void);
+
+#endif /* !__POLL_SCHEDULE_H__ */
@@ -1,4 +1,5 @@
 /* Generated by the program. DO NOT EDIT! */
+#include <string.h>
 #include "base_station.pb.h"
 static inline bool is_full(uint8_t *bufp, uint8_t *end)
 {
@@ -38,6 +39,22 @@ static bool uint32_to_proto_helper(uint8_t **buf, uint8_t *end,
   }
 }
 
+static bool bytes_to_proto_helper(uint8_t **buf, uint8_t *end, uint32_t field,
+                                  const uint8_t *value, uint8_t len)
+{
+  uint8_t *bufp = *buf;
+
+  uint32_to_proto(&bufp, end, field << 3 | 2);
+  uint32_to_proto(&bufp, end, len);
+
+  if (is_full(bufp + len, end)) {
+    return false;
+  } else {
+    memcpy(bufp, value, len);
+    *buf = bufp + len;
+    return true;
+  }
+}
 
 bool serialize_NfcBaseStationInfo__battery_voltage(uint8_t **buf, uint8_t *end, uint32_t value)
 {
@@ -69,3 +86,27 @@ bool serialize_NfcBaseStationInfo__number_brown_out(uint8_t **buf, uint8_t *end,
   return uint32_to_proto_helper(buf, end, 3, value);
 }
 
+bool serialize_NfcBaseStationInfo__poll_interval_ms(uint8_t **buf, uint8_t *end, uint32_t value)
+{
+  return uint32_to_proto_helper(buf, end, 7, value);
+}
+
+bool serialize_NfcBaseStationInfo__target_mode_retry(uint8_t **buf, uint8_t *end, uint32_t value)
+{
+  return uint32_to_proto_helper(buf, end, 8, value);
+}
+
+bool serialize_NfcBaseStationInfo__touch_to_push_ms(uint8_t **buf, uint8_t *end, const uint8_t *value, uint8_t len)
+{
+  return bytes_to_proto_helper(buf, end, 9, value, len);
+}
+
+bool serialize_NfcBaseStationInfo__poll_to_detect_ms(uint8_t **buf, uint8_t *end, const uint8_t *value, uint8_t len)
+{
+  return bytes_to_proto_helper(buf, end, 10, value, len);
+}
+
+bool serialize_NfcBaseStationInfo__llcp_session_ms(uint8_t **buf, uint8_t *end, const uint8_t *value, uint8_t len)
+{
+  return bytes_to_proto_helper(buf, end, 11, value, len);
+}
@@ -8,3 +8,8 @@ bool serialize_NfcBaseStationInfo__number_serial_failure(uint8_t **buf, uint8_t
 bool serialize_NfcBaseStationInfo__number_watchdog(uint8_t **buf, uint8_t *end, uint32_t value);
 bool serialize_NfcBaseStationInfo__number_external_reset(uint8_t **buf, uint8_t *end, uint32_t value);
 bool serialize_NfcBaseStationInfo__number_brown_out(uint8_t **buf, uint8_t *end, uint32_t value);
+bool serialize_NfcBaseStationInfo__poll_interval_ms(uint8_t **buf, uint8_t *end, uint32_t value);
+bool serialize_NfcBaseStationInfo__target_mode_retry(uint8_t **buf, uint8_t *end, uint32_t value);
+bool serialize_NfcBaseStationInfo__touch_to_push_ms(uint8_t **buf, uint8_t *end, const uint8_t *value, uint8_t len);
+bool serialize_NfcBaseStationInfo__poll_to_detect_ms(uint8_t **buf, uint8_t *end, const uint8_t *value, uint8_t len);
+bool serialize_NfcBaseStationInfo__llcp_session_ms(uint8_t **buf, uint8_t *end, const uint8_t *value, uint8_t len);
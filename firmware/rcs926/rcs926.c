@@ -25,7 +25,7 @@
 #include <util/delay.h>
 
 #include "../nfc/type3tag.h"
-#include "../peripheral/lcd.h"
+#include "../peripheral/log.h"
 #include "../peripheral/three_wire.h"
 
 #include "rcs926.h"
@@ -99,7 +99,7 @@ void rcs926_process_command(uint8_t ndef[], uint16_t ndef_len,
     } else {
       for (i = 0; i < num_blocks; i++) {
         uint16_t block_num = __read_block_number();
-        lcd_printf(1, "Felica RD %i %i", block_num, num_blocks);
+        log_printf(LOG_DEBUG, 1, "Felica RD %i %i", block_num, num_blocks);
         if (block_num == 0) {
           attribute_block(data, ndef_len);
         } else if (block_num > NUM_BLOCKS(ndef_len)) {
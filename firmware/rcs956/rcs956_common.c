@@ -25,9 +25,10 @@
 #include <avr/pgmspace.h>
 #include <util/delay.h>
 
-#include "../peripheral/lcd.h"
+#include "../peripheral/log.h"
 #include "../peripheral/usart.h"
 #include "rcs956_protocol.h"
+#include "rcs956_shadow.h"
 
 #include "rcs956_common.h"
 
@@ -53,10 +54,11 @@ int rcs956_comm_thru_ex(uint8_t *payload, size_t payload_len,
 {
   static const prog_char __cmd[] = {CMD, COMM_THRU_EX};
 
-  uint8_t cmd[MAX_SEND_SIZE];
+  // Header only, the payload is sent from the caller's buffer
+  uint8_t cmd[sizeof(__cmd) + 2];
   uint8_t *idx = cmd;
 
-  if (payload_len > sizeof(cmd) - sizeof(__cmd)) {
+  if (payload_len > MAX_SEND_SIZE - sizeof(cmd)) {
     protocol_errno = BUFFER_EXCEEDED;
     return 0;
   }
@@ -66,21 +68,20 @@ int rcs956_comm_thru_ex(uint8_t *payload, size_t payload_len,
   // Time-out in 0.5ms increments (multiply by 2 with left shift)
   *idx++ = L8(timeout << 1);
   *idx++ = H8(timeout << 1);
-  memcpy(idx, payload, payload_len);
-  idx += payload_len;
 
-  if (!rcs956_send_command(cmd, idx - cmd)) {
-    lcd_printf(0, "ctex send fail");
+  if (!rcs956_send_command_data(cmd, idx - cmd, payload, payload_len,
+                                resp, resp_len)) {
+    log_printf(LOG_ERROR, 0, "ctex send fail");
     return 0;
   }
 
-  if (!rcs956_read_response(resp, resp_len)) {
-    lcd_printf(0, "ctex resp fail %d", resp[OFS_DATA_LEN]);
+  if (!rcs956_read_response()) {
+    log_printf(LOG_ERROR, 0, "ctex resp fail %d", resp[OFS_DATA_LEN]);
     return 0;
   }
 
   if (resp[OFS_DATA] != 0x00) { // First byte is status
-    lcd_printf(0, "ctex st fail %02X", resp[OFS_DATA]);
+    log_printf(LOG_ERROR, 0, "ctex st fail %02X", resp[OFS_DATA]);
     protocol_errno = UNEXPECTED_REPLY;
     return 0;
   }
@@ -98,13 +99,18 @@ bool rcs956_reset(void)
   static const prog_char __cmd[] = {0xd4, 0x18, 0x01};
   uint8_t resp[MAX_RECV_SIZE];
 
-  if (!rcs956_send_command_p(__cmd, sizeof(__cmd))) {
-    lcd_printf(0, "reset fail");
+  // Nothing to do if the module is still in mode 0 from the last reset
+  if (rcs956_shadow_is_reset()) {
+    return true;
+  }
+
+  if (!rcs956_send_command_p(__cmd, sizeof(__cmd), resp, sizeof(resp))) {
+    log_printf(LOG_ERROR, 0, "reset fail");
     return false;
   }
 
-  if (!rcs956_read_response(resp, sizeof(resp))) {
-    lcd_printf(1, "rst rs fail %d %02X", resp[3], resp[5]);
+  if (!rcs956_read_response()) {
+    log_printf(LOG_ERROR, 1, "rst rs fail %d %02X", resp[3], resp[5]);
     return false;
   }
 
@@ -112,6 +118,7 @@ bool rcs956_reset(void)
   rcs956_cancel_cmd();
   _delay_ms(10);
 
+  rcs956_shadow_set_reset();
   return true;
 }
 
@@ -123,5 +130,7 @@ void rcs956_serial_wake_up(void)
   static const prog_char __cmd_wake_up[] = {0x55};
 
   usart_send_buf_p(__cmd_wake_up, (int)sizeof(__cmd_wake_up));
+  usart_flush();
   _delay_ms(2);
+  rcs956_shadow_invalidate();
 }
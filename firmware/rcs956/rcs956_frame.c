@@ -0,0 +1,244 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Assembles RC-S956 frames from the USART RX interrupt, one byte at a time.
+ * LCS, DCS and the postamble are checked as the bytes arrive, so a frame is
+ * complete and verified as soon as its postamble is received.
+ *
+ * Frames go to the buffer armed with rcs956_frame_receive, which is armed
+ * for the response before its command is sent. The ACK for the command
+ * lands in the same buffer and is only flagged, so the response that
+ * follows right behind it goes straight into place. Bytes arriving while
+ * no buffer is armed are dropped.
+ *
+ * Frame format (Host Packet Format - Normal Frame):
+ * 0x00    : 0x00             (Preamble)
+ * 0x01    : 0x00             (Start of Packet)
+ * 0x02    : 0xff
+ * 0x03    : Length of data   (LEN)
+ * 0x04    : checksum of LEN  (LCS)
+ * 0x05    : data             (max 255 bytes)
+ * LEN+0x05: checksum of data (DCS)
+ * LEN+0x06: 0x00             (Postamble)
+ *
+ * ACK is 00 00 ff 00 ff 00, without data and DCS.
+ */
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "rcs956_frame.h"
+
+enum FRAME_STATE {
+  WAIT_START,
+  WAIT_START_FF,
+  WAIT_LEN,
+  WAIT_LCS,
+  WAIT_DATA,
+  WAIT_DCS,
+  WAIT_POSTAMBLE,
+  WAIT_ACK_POSTAMBLE,
+};
+
+/* Armed buffer, NULL while received bytes are dropped */
+static uint8_t *__buffer;
+static uint8_t __buffer_size;
+
+static volatile uint8_t __state;
+static uint8_t __index;
+static uint8_t __remaining;
+static uint8_t __sum;
+
+static volatile bool __acked;
+static volatile bool __done;
+static uint8_t __size;
+static enum PROTOCOL_ERROR __error;
+
+/*
+ * Ends the current frame and disarms the buffer.
+ */
+static void __end_frame(enum PROTOCOL_ERROR error)
+{
+  __error = error;
+  __size = __index;
+  __buffer = NULL;
+  __index = 0;
+  __state = WAIT_START;
+  __done = true;
+}
+
+/*
+ * Flags the ACK and keeps the buffer armed for the response.
+ */
+static void __end_ack(void)
+{
+  __acked = true;
+  __index = 0;
+  __state = WAIT_START;
+}
+
+/*
+ * Feeds one received byte to the frame state machine. Bytes outside a
+ * frame are skipped until the next 00 ff start of packet.
+ */
+void rcs956_frame_feed(uint8_t c)
+{
+  if (__buffer == NULL)
+    return;
+
+  switch (__state) {
+    case WAIT_START:
+      if (c == 0x00)
+        __state = WAIT_START_FF;
+      return;
+    case WAIT_START_FF:
+      if (c == 0xff) {
+        // Stored in full even if the preamble was missing
+        __buffer[0] = 0x00;
+        __buffer[1] = 0x00;
+        __buffer[2] = 0xff;
+        __index = 3;
+        __state = WAIT_LEN;
+      } else if (c != 0x00) {
+        __state = WAIT_START;
+      }
+      return;
+  }
+
+  if (__index >= __buffer_size) {
+    __end_frame(BUFFER_EXCEEDED);
+    return;
+  }
+  __buffer[__index++] = c;
+
+  switch (__state) {
+    case WAIT_LEN:
+      __remaining = c;
+      __state = WAIT_LCS;
+      break;
+    case WAIT_LCS:
+      if (__remaining == 0 && c == 0xff) {  // ACK
+        __state = WAIT_ACK_POSTAMBLE;
+      } else if (__remaining == 0 || (uint8_t)(__remaining + c) != 0) {
+        __end_frame(CHECKSUM_ERROR);
+      } else if ((uint16_t)__remaining + 7 > __buffer_size) {
+        __end_frame(BUFFER_EXCEEDED);
+      } else {
+        __sum = 0;
+        __state = WAIT_DATA;
+      }
+      break;
+    case WAIT_DATA:
+      __sum += c;
+      if (--__remaining == 0)
+        __state = WAIT_DCS;
+      break;
+    case WAIT_DCS:
+      if ((uint8_t)(__sum + c) != 0) {
+        __end_frame(CHECKSUM_ERROR);
+      } else {
+        __state = WAIT_POSTAMBLE;
+      }
+      break;
+    case WAIT_POSTAMBLE:
+      __end_frame(c == 0x00 ? SUCCESS : UNEXPECTED_REPLY);
+      break;
+    case WAIT_ACK_POSTAMBLE:
+      if (c == 0x00) {
+        __end_ack();
+      } else {
+        __end_frame(UNEXPECTED_REPLY);
+      }
+      break;
+  }
+}
+
+/*
+ * Arms buffer, or with NULL disarms, dropping any partial frame.
+ */
+static void __arm(uint8_t *buffer, uint8_t buffer_size)
+{
+  uint8_t sreg = SREG;
+
+  cli();
+  __buffer = buffer;
+  __buffer_size = buffer_size;
+  __index = 0;
+  __state = WAIT_START;
+  __acked = false;
+  __done = false;
+  SREG = sreg;
+}
+
+/*
+ * Arms buffer for the ACK and the frame that follows it. Arm before
+ * sending the command, as bytes are dropped while nothing is armed.
+ * The buffer must hold at least the 6 bytes of an ACK.
+ */
+void rcs956_frame_receive(uint8_t *buffer, size_t buffer_size)
+{
+  if (buffer_size > 0xff)
+    buffer_size = 0xff;
+
+  __arm(buffer, buffer_size);
+}
+
+/*
+ * Returns true once an ACK has been received into the armed buffer.
+ */
+bool rcs956_frame_acked(void)
+{
+  return __acked;
+}
+
+/*
+ * Returns true once the frame in the armed buffer is complete or failed.
+ */
+bool rcs956_frame_done(void)
+{
+  return __done;
+}
+
+/*
+ * Returns SUCCESS if the completed frame is valid, otherwise the reason.
+ */
+enum PROTOCOL_ERROR rcs956_frame_error(void)
+{
+  return __error;
+}
+
+/*
+ * Returns the number of bytes stored for the completed frame.
+ */
+uint8_t rcs956_frame_size(void)
+{
+  return __size;
+}
+
+/*
+ * Returns true if a frame has started arriving or is complete.
+ */
+bool rcs956_frame_pending(void)
+{
+  return (__state != WAIT_START || __done);
+}
+
+/*
+ * Drops partial frames and disarms the buffer.
+ */
+void rcs956_frame_reset(void)
+{
+  __arm(NULL, 0);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Assembles RC-S956 frames from the USART RX interrupt, one byte at a time.
+ */
+
+#ifndef __RCS956_FRAME_H__
+#define __RCS956_FRAME_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rcs956_protocol.h"
+
+// Feeds one received byte, called from the RX interrupt
+void rcs956_frame_feed(uint8_t c);
+
+// Arms the buffer for an ACK and the next frame (at most 255 bytes are used)
+void rcs956_frame_receive(uint8_t *buffer, size_t buffer_size);
+
+// True once an ACK has been received into the armed buffer
+bool rcs956_frame_acked(void);
+
+// True once the frame in the armed buffer is complete or failed
+bool rcs956_frame_done(void);
+
+// Result of the completed frame: SUCCESS or the reason it failed
+enum PROTOCOL_ERROR rcs956_frame_error(void);
+
+// Size of the completed frame including header and postamble
+uint8_t rcs956_frame_size(void);
+
+// True if a frame has started arriving or is complete
+bool rcs956_frame_pending(void);
+
+// Drops partial frames and disarms the buffer
+void rcs956_frame_reset(void);
+
+#endif /* !__RCS956_FRAME_H__ */
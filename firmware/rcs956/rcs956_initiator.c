@@ -23,13 +23,56 @@
 #include <util/delay.h>
 
 #include "rcs956_protocol.h"
-#include "../peripheral/lcd.h"
+#include "rcs956_shadow.h"
+#include "../peripheral/log.h"
 
 #include "rcs956_initiator.h"
 
 #define CMD 0xd4
 #define RF_CONFIG 0x32
 #define LIST_TGT 0x4a
+#define IN_RELEASE 0x52
+
+/*
+ * Sends a command, waits for ACK, and reads response. Times out after
+ * USART_READ_TIMEOUT.
+ */
+bool __execute_command(
+    uint8_t *cmd, int cmd_size, uint8_t *resp, int resp_size)
+{
+  if (!rcs956_send_command(cmd, cmd_size, resp, resp_size)) {
+    return false;
+  }
+
+  return rcs956_read_response();
+}
+
+/*
+ * Executes an RFConfiguration command (CMD, RF_CONFIG, item, settings)
+ * unless the module already has these settings.
+ */
+static bool __rf_config(uint8_t *cmd, int cmd_size)
+{
+  uint8_t resp[MAX_RECV_SIZE];
+
+  if (rcs956_shadow_has_rf_config(cmd[2], &cmd[3], cmd_size - 3)) {
+    return true;
+  }
+  if (!__execute_command(cmd, cmd_size, resp, sizeof(resp))) {
+    return false;
+  }
+  rcs956_shadow_set_rf_config(cmd[2], &cmd[3], cmd_size - 3);
+  return true;
+}
+
+static bool __rf_off(void)
+{
+  static const prog_char __cmd_rf_off[] = {CMD, RF_CONFIG, 0x01, 0x00};
+  uint8_t cmd[sizeof(__cmd_rf_off)];
+
+  memcpy_P(cmd, __cmd_rf_off, sizeof(__cmd_rf_off));
+  return __rf_config(cmd, sizeof(cmd));
+}
 
 /**
  * Turn off RF field.
@@ -38,25 +81,49 @@
  */
 void rcs956_rf_off(void)
 {
+  (void)__rf_off();
+}
+
+/**
+ * Releases the targets found by InListPassiveTarget and turns off the RF
+ * field. Leaves initiator mode without the delays of rcs956_reset, so
+ * TgInitAsTarget can follow right away. Sends nothing unless a poll may
+ * have left targets listed.
+ *
+ * returns true on success, false if the module needs a reset
+ */
+bool rcs956_in_release(void)
+{
+  static const prog_char __cmd_release[] = {CMD, IN_RELEASE, 0x00};
+  uint8_t cmd[sizeof(__cmd_release)];
   uint8_t resp[MAX_RECV_SIZE];
 
-  static const prog_char __cmd_rf_off[] = {CMD, RF_CONFIG, 0x01, 0x00};
+  if (!rcs956_shadow_has_target()) {
+    return false;
+  }
 
-  (void)rcs956_send_command_p(__cmd_rf_off, sizeof(__cmd_rf_off));
-  (void)rcs956_read_response(resp, sizeof(resp));
+  memcpy_P(cmd, __cmd_release, sizeof(__cmd_release));
+  if (!__execute_command(cmd, sizeof(cmd), resp, sizeof(resp))) {
+    log_printf(LOG_ERROR, 0, "rel fail %i", protocol_errno);
+    return false;
+  }
+  if (resp[OFS_DATA] != 0x00) { // Status
+    log_printf(LOG_ERROR, 0, "rel st fail %02X", resp[OFS_DATA]);
+    protocol_errno = UNEXPECTED_REPLY;
+    return false;
+  }
+  return __rf_off();
 }
 
 /**
- * Checks whether a card (phone) is present, If so, returns true
- * and fills the idm and pmm buffers.
+ * Starts polling for a card (phone) and returns without waiting for the
+ * result, which goes to resp. Finish with initiator_poll_finish.
  *
- * returns true if card (phone) successfully detected
- *         false if no card detected (timeout) or error occurred
+ * returns true if the poll command was sent
  */
-bool initiator_poll(uint8_t idm[], uint8_t pmm[], uint16_t syscode)
+bool initiator_poll_start(uint8_t resp[], size_t resp_len, uint16_t syscode)
 {
   uint8_t cmd[MAX_SEND_SIZE];
-  uint8_t resp[MAX_RECV_SIZE];
 
   // Felica InListPassiveTarget Request
   // 0x00: 0xd4 Command Code
@@ -97,18 +164,28 @@ bool initiator_poll(uint8_t idm[], uint8_t pmm[], uint16_t syscode)
   memcpy_P(&cmd[sizeof(cmd_poll_prefix) + 2], cmd_poll_suffix,
            sizeof(cmd_poll_suffix));
 
-  if (!rcs956_send_command(cmd,
-                           sizeof(cmd_poll_prefix)
-                           + sizeof(cmd_poll_suffix) + 2)) {
-    return false;
-  }
+  return rcs956_send_command(cmd,
+                             sizeof(cmd_poll_prefix)
+                             + sizeof(cmd_poll_suffix) + 2,
+                             resp, resp_len);
+}
 
-  if (!rcs956_read_response(resp, sizeof(resp))) {
+/**
+ * Waits for the poll started by initiator_poll_start. If a card (phone) is
+ * present, returns true and fills the idm and pmm buffers.
+ *
+ * returns true if card (phone) successfully detected
+ *         false if no card detected (timeout) or error occurred
+ */
+bool initiator_poll_finish(const uint8_t resp[], uint8_t idm[], uint8_t pmm[])
+{
+  if (!rcs956_read_response()) {
     return false;
   }
 
   // If no card found (NbTg = 0), just return
   if (resp[7] != 0x01) {
+    rcs956_shadow_no_target();
     return false;
   }
 
@@ -119,20 +196,22 @@ bool initiator_poll(uint8_t idm[], uint8_t pmm[], uint16_t syscode)
   return true;
 }
 
-/*
- * Sends a command, waits for ACK, and reads response. Times out after
- * USART_READ_TIMEOUT.
+/**
+ * Checks whether a card (phone) is present, If so, returns true
+ * and fills the idm and pmm buffers.
+ *
+ * returns true if card (phone) successfully detected
+ *         false if no card detected (timeout) or error occurred
  */
-bool __execute_command(
-    uint8_t *cmd, int cmd_size, uint8_t *resp, int resp_size)
+bool initiator_poll(uint8_t idm[], uint8_t pmm[], uint16_t syscode)
 {
-  if (!rcs956_send_command(cmd, cmd_size)) {
-    return false;
-  }
+  uint8_t resp[MAX_RECV_SIZE];
 
-  return rcs956_read_response(resp, resp_size);
+  return (initiator_poll_start(resp, sizeof(resp), syscode) &&
+          initiator_poll_finish(resp, idm, pmm));
 }
 
+
 /*
  * Defines the retry count for RF communication for InListPassiveTarget,
  * i.e. when polling for a device.
@@ -142,14 +221,13 @@ bool rcs956_set_retry(uint8_t retry)
 {
   static const prog_char __cmd_rf_retry[] = {CMD, RF_CONFIG, 0x05};
   uint8_t cmd[6];
-  uint8_t resp[MAX_RECV_SIZE];
 
   memcpy_P(cmd, __cmd_rf_retry, sizeof(__cmd_rf_retry));
   cmd[3] = retry; // ATR_REQ, we do not use
   cmd[4] = 0x00; // PSL_REQ, 0 = default
   cmd[5] = retry; // InListPassiveTarget
 
-  return __execute_command(cmd, sizeof(cmd), resp, sizeof(resp));
+  return __rf_config(cmd, sizeof(cmd));
 }
 
 /*
@@ -161,12 +239,11 @@ bool rcs956_set_retry_com(uint8_t retry)
 {
   static const prog_char __cmd_rf_retry_com[] = {CMD, RF_CONFIG, 0x04};
   uint8_t cmd[4];
-  uint8_t resp[MAX_RECV_SIZE];
 
   memcpy_P(cmd, __cmd_rf_retry_com, sizeof(__cmd_rf_retry_com));
   cmd[3] = retry;
 
-  return __execute_command(cmd, sizeof(cmd), resp, sizeof(resp));
+  return __rf_config(cmd, sizeof(cmd));
 }
 
 /*
@@ -177,12 +254,11 @@ bool rcs956_set_timeout(uint8_t timeout)
 {
   static const prog_char __cmd_timeout[] = {CMD, RF_CONFIG, 0x02};
   uint8_t cmd[6];
-  uint8_t resp[MAX_RECV_SIZE];
 
   memcpy_P(cmd, __cmd_timeout, sizeof(__cmd_timeout));
   cmd[3] = 0x0b; // PSL_RES timeout (default)
   cmd[4] = 0x0b; // ATR_RES timeout (default)
   cmd[5] = timeout; // Set RC Communication timeout value
 
-  return __execute_command(cmd, sizeof(cmd), resp, sizeof(resp));
+  return __rf_config(cmd, sizeof(cmd));
 }
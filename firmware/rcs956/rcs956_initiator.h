@@ -19,15 +19,23 @@
 #ifndef __RCS956_INITIATOR_H__
 #define __RCS956_INITIATOR_H__
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
 // Turn off RF field.
 void rcs956_rf_off(void);
 
+// Leaves initiator mode without a reset, ready for target mode.
+bool rcs956_in_release(void);
+
 // Checks whether a target (card, phone) is present.
 bool initiator_poll(uint8_t idm[], uint8_t pmm[], uint16_t syscode);
 
+// Same as initiator_poll, split to compute while the module polls
+bool initiator_poll_start(uint8_t resp[], size_t resp_len, uint16_t syscode);
+bool initiator_poll_finish(const uint8_t resp[], uint8_t idm[], uint8_t pmm[]);
+
 // Defines the retry count for RF communication for InListPassiveTarget
 bool rcs956_set_retry(uint8_t retry);
 
@@ -21,11 +21,17 @@
 
 #include <string.h>
 
+#include <avr/interrupt.h>
 #include <avr/io.h>
 #include <avr/pgmspace.h>
+#include <avr/sleep.h>
 #include <util/delay.h>
 
+#include "../peripheral/timeout.h"
 #include "../peripheral/usart.h"
+#include "../trace.h"
+#include "rcs956_frame.h"
+#include "rcs956_shadow.h"
 
 #include "rcs956_protocol.h"
 
@@ -50,78 +56,122 @@ static uint8_t __checksum_base(const uint8_t *data, size_t len)
 }
 
 /*
- * Reads response from RC-S620/S. Waits max of USART_READ_TIMEOUT before
- * timing out.
+ * Arms resp_buffer for the ACK and the response to the next command.
  *
- * Arguments:
- * resp_buffer: buffer to save response.
- * resp_buffer_size: size of the buffer. (at least 6 bytes)
+ * Returns false if the buffer cannot hold an ACK. protocol_errorno
+ * contains error code.
+ */
+static bool __receive(uint8_t *resp_buffer, size_t resp_buffer_size)
+{
+  // We need at least enough room for the ACK
+  if (resp_buffer_size < sizeof(__cmd_ack)) {
+    protocol_errno = BUFFER_EXCEEDED;
+    return false;
+  }
+
+  rcs956_frame_receive(resp_buffer, resp_buffer_size);
+  return true;
+}
+
+/*
+ * Waits for the ACK if ack is set, otherwise for the frame in the armed
+ * buffer. Sleeps in idle mode while the frame is assembled from the RX
+ * interrupt, max of USART_READ_TIMEOUT before timing out.
  *
  * Returns:
- * size of the response if succeeded.
- * Otherwise, 0, protocol_errorno contains error code.
+ * true if the ACK or a valid frame arrived.
+ * Otherwise, false, protocol_errorno contains error code.
  */
-static size_t __read_response(uint8_t *resp_buffer, size_t resp_buffer_size)
+static bool __wait_frame(bool ack)
 {
-  size_t i;
-  size_t read_size = resp_buffer_size;
-  uint16_t timeout_counter = 0;
-  /*
-   * Read data format (Host Packet Format - Normal Frame)):
-   * 0x00    : 0x00             (Preamble)
-   * 0x01    : 0x00             (Start of Packet)
-   * 0x02    : 0xff
-   * 0x03    : Length of data   (LEN)
-   * 0x04    : checksum of LEN  (LCS)
-   * 0x05    : data             (max 255 bytes)
-   * LEN+0x05: checksum of data (DCS)
-   * LEN+0x06: 0x00             (Postamble)
-   */
+  timeout_start(USART_READ_TIMEOUT);
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  for (;;) {
+    // Sleep only if the frame is not done, without missing its interrupt
+    cli();
+    if ((ack && rcs956_frame_acked()) || rcs956_frame_done()
+        || timeout_expired()) {
+      sei();
+      break;
+    }
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+  }
+  timeout_stop();
 
-  // We need at least enough room to read the packet length
-  if (resp_buffer_size <= OFS_DATA_LEN) {
+  if (!(ack && rcs956_frame_acked()) && !rcs956_frame_done()) {
     rcs956_cancel_cmd();
-    protocol_errno = BUFFER_EXCEEDED;
-    return 0;
+    // The module may have been disconnected and lost its configuration
+    rcs956_shadow_invalidate();
+    protocol_errno = TIMEOUT;
+    return false;
   }
-
-  for (i = 0; i < read_size; i++) {
-    while (!usart_has_data()) { /* check timeout */
-      if (timeout_counter++ > USART_READ_TIMEOUT * 10) {
-        rcs956_cancel_cmd();
-        protocol_errno = TIMEOUT;
-        return 0;
-      }
-      _delay_us(100); /* 1.44 bytes delay at 115200 bps */
-    }
-    resp_buffer[i] = usart_get();
-    // How many bytes to expect
-    if (i == OFS_DATA_LEN) {
-      read_size = (resp_buffer[i] == 0) ? 6 : (resp_buffer[i] + 7);
-      if (read_size > resp_buffer_size) {
-        rcs956_cancel_cmd();
-        protocol_errno = BUFFER_EXCEEDED;
-        return 0;
-      }
-    }
+  if (rcs956_frame_done() && rcs956_frame_error() != SUCCESS) {
+    rcs956_cancel_cmd();
+    protocol_errno = rcs956_frame_error();
+    return false;
   }
+  return true;
+}
 
-  // Todo: verify checksum (note: no checksum if resp_buffer[3] == 0)
-  return read_size;
+/*
+ * Checks that a response is long enough to hold command, subcommand and
+ * status.
+ */
+static bool __check_response(size_t resp_size)
+{
+  /* 00 00 ff len csum d4 cmd status payload(>=0) csum 00 */
+  if (resp_size == 0) { /* __wait_frame failed */
+    trace(TRACE_RCS956_RESP, protocol_errno);
+    return false;
+  } else if (resp_size < 9) {
+    protocol_errno = UNEXPECTED_REPLY;
+    trace(TRACE_RCS956_RESP, protocol_errno);
+    return false;
+  } else {
+    trace(TRACE_RCS956_RESP, SUCCESS);
+    return true;
+  }
 }
 
 /**
  * Sends a command to Felica module. Waits max of USART_READ_TIMEOUT for ACK
- * from module before timing out and returning an error.
+ * from module before timing out and returning an error. Does not wait for
+ * the response, so that the caller can compute while the module works;
+ * finish with rcs956_read_response before the next command.
  *
  * Arguments:
  * cmd: command bytes to send.
  * cmd_len: length of the bytes.
+ * resp_buffer: buffer for the response, armed before the command is sent;
+ *              must stay valid until rcs956_read_response.
+ * resp_buffer_size: size of the buffer. (at least 6 bytes)
  */
-bool rcs956_send_command(const uint8_t *cmd, size_t cmd_len)
+bool rcs956_send_command(const uint8_t *cmd, size_t cmd_len,
+                         uint8_t *resp_buffer, size_t resp_buffer_size)
+{
+  return rcs956_send_command_data(cmd, cmd_len, NULL, 0,
+                                  resp_buffer, resp_buffer_size);
+}
+
+/**
+ * Sends a command made of a header and data in separate buffers, so that
+ * callers need not copy large data behind the header. Otherwise the same
+ * as rcs956_send_command.
+ *
+ * Arguments:
+ * cmd: command bytes to send.
+ * cmd_len: length of the bytes.
+ * data: bytes to send after cmd, may be NULL if data_len is 0.
+ * data_len: length of data.
+ * resp_buffer, resp_buffer_size: as rcs956_send_command.
+ */
+bool rcs956_send_command_data(const uint8_t *cmd, size_t cmd_len,
+                              const uint8_t *data, size_t data_len,
+                              uint8_t *resp_buffer, size_t resp_buffer_size)
 {
-  size_t resp_size;
-  uint8_t resp_buffer[8];
   /*
    * send data format(normal frame):
    * 0x00: 0x00             (Preamble)
@@ -134,32 +184,57 @@ bool rcs956_send_command(const uint8_t *cmd, size_t cmd_len)
    * 0x07: 0x00             (Postamble)
    */
 
+  trace(TRACE_RCS956_CMD, cmd[1]);
+
+  // Replies are assembled by the frame parser from the RX interrupt
+  usart_set_receive_handler(rcs956_frame_feed);
+
+  // Armed before sending, so the response can follow the ACK at once
+  if (!__receive(resp_buffer, resp_buffer_size)) {
+    trace(TRACE_RCS956_ACK, protocol_errno);
+    return false;
+  }
+
+  rcs956_shadow_command(cmd);
+
   // Preamble and Start of Packet
   usart_send_buf_p(__packet_header,(int)sizeof(__packet_header));
 
   // length of command
-  usart_send(cmd_len);
+  usart_send(cmd_len + data_len);
 
   // checksum of length
-  usart_send(0x100 - cmd_len);
+  usart_send(0x100 - (cmd_len + data_len));
 
   // command
   usart_send_buf(cmd,cmd_len);
+  if (data_len > 0) {
+    usart_send_buf(data,data_len);
+  }
 
   // checksum of command
-  usart_send(__checksum_base(cmd,cmd_len));
+  if (data_len > 0) {
+    usart_send(__checksum_base(cmd,cmd_len) + __checksum_base(data,data_len));
+  } else {
+    usart_send(__checksum_base(cmd,cmd_len));
+  }
 
   // Postamble
   usart_send_buf_p(__packet_footer,sizeof(__packet_footer));
 
+  // Start the ACK timeout only once the frame has left the MCU
+  usart_flush();
+
   // ACK: 00 00 ff 00 ff 00
-  resp_size = __read_response(resp_buffer, sizeof(resp_buffer));
-  if (resp_size == 0) { /* __read_response failed */
+  if (!__wait_frame(true)) {
+    trace(TRACE_RCS956_ACK, protocol_errno);
     return false;
-  } else if (resp_size != 6) {
+  } else if (!rcs956_frame_acked()) {
     protocol_errno = UNEXPECTED_REPLY;
+    trace(TRACE_RCS956_ACK, protocol_errno);
     return false;
   } else {
+    trace(TRACE_RCS956_ACK, SUCCESS);
     return true;
   }
 }
@@ -171,15 +246,20 @@ bool rcs956_send_command(const uint8_t *cmd, size_t cmd_len)
  * Arguments:
  * cmd: command bytes in the program memory to send.
  * cmd_len: length of the bytes.
+ * resp_buffer, resp_buffer_size: as rcs956_send_command.
  */
-bool rcs956_send_command_p(const prog_char *cmd, size_t cmd_len)
+bool rcs956_send_command_p(const prog_char *cmd, size_t cmd_len,
+                           uint8_t *resp_buffer, size_t resp_buffer_size)
 {
   uint8_t buf[cmd_len];
   memcpy_P(buf,cmd,cmd_len);
-  return rcs956_send_command(buf,cmd_len);
+  return rcs956_send_command(buf,cmd_len,resp_buffer,resp_buffer_size);
 }
 
 /*
+ * Waits for the response to the command sent by rcs956_send_command, in
+ * the buffer passed with it. Waits max of USART_READ_TIMEOUT from now.
+ *
  * response data:
  * 0x00: 0x00
  * 0x01: 0x00
@@ -192,23 +272,23 @@ bool rcs956_send_command_p(const prog_char *cmd, size_t cmd_len)
  * size + 0x05: checksum
  * size + 0x06: 0x00
  */
-bool rcs956_read_response(uint8_t *resp_buffer, size_t resp_buffer_size)
+bool rcs956_read_response(void)
 {
-  /* 00 00 ff len csum d4 cmd status payload(>=0) csum 00 */
-  size_t resp_size = __read_response(resp_buffer, resp_buffer_size);
-  if (resp_size == 0) { /* __read_response failed */
-    return false;
-  } else if (resp_size < 9) {
-    protocol_errno = UNEXPECTED_REPLY;
-    return false;
-  } else {
-    return true;
-  }
+  return __check_response(__wait_frame(false) ? rcs956_frame_size() : 0);
+}
+
+/**
+ * Returns true once the response to the sent command has started to
+ * arrive.
+ */
+bool rcs956_response_started(void)
+{
+  return rcs956_frame_pending();
 }
 
 /**
- * Sends ACK to Felica module, which cancels any pending command. Flushes the
- * receive buffer because the RC-S620 may transmit data while we send the
+ * Sends ACK to Felica module, which cancels any pending command. Drops
+ * partially received frames because the RC-S620 may transmit data while we send the
  * ACK.
  *
  * Sending ACK against receiving a response from Felica module is optional.
@@ -216,6 +296,7 @@ bool rcs956_read_response(uint8_t *resp_buffer, size_t resp_buffer_size)
  */
 void rcs956_cancel_cmd(void)
 {
+  trace(TRACE_RCS956_CANCEL, 0);
   usart_send_buf_p(__cmd_ack,(int)sizeof(__cmd_ack));
   /* 5 ms wait below are:
    * - 1 ms for transfering the ACK command to the RC-S620.
@@ -223,5 +304,5 @@ void rcs956_cancel_cmd(void)
    * - 3 ms for pessimistically waiting for receiving all reply before ACK.
    */
   _delay_ms(5);
-  usart_clear_receive_buffer();
+  rcs956_frame_reset();
 }
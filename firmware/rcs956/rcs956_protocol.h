@@ -32,6 +32,7 @@ extern enum PROTOCOL_ERROR {
   TIMEOUT,
   BUFFER_EXCEEDED,
   UNEXPECTED_REPLY,
+  CHECKSUM_ERROR,
 } protocol_errno;
 
 
@@ -41,12 +42,7 @@ extern enum PROTOCOL_ERROR {
 #define L8(x) (x & 0xff)
 #define H8(x) ((x >> 8) & 0xff)
 
-/*
- * USART_READ_TIMEOUT <= 65535(MAX_COUNTER) * 1024(PRESCALE) * 1000(MS) / F_CPU
- *
- * e.g. 20   MHz:  3355
- *       3.58MHz: 18745
- */
+// Max wait for a complete frame, see peripheral/timeout.h
 #define USART_READ_TIMEOUT 3000 /* ms */
 
 // The offset of the byte that describes the total packet length
@@ -61,14 +57,24 @@ extern enum PROTOCOL_ERROR {
 // The offset of the data section in a packet to/from RC-S620
 #define OFS_DATA 7
 
-// Send command to RC-S956
-bool rcs956_send_command(const uint8_t *cmd, size_t cmd_len);
+// Send command to RC-S956, arming resp_buffer for its response
+bool rcs956_send_command(const uint8_t *cmd, size_t cmd_len,
+                         uint8_t *resp_buffer, size_t resp_buffer_size);
+
+// Send command header followed by data to RC-S956
+bool rcs956_send_command_data(const uint8_t *cmd, size_t cmd_len,
+                              const uint8_t *data, size_t data_len,
+                              uint8_t *resp_buffer, size_t resp_buffer_size);
 
 // Send command from program memory to RC-S956
-bool rcs956_send_command_p(const prog_char *cmd, size_t cmd_len);
+bool rcs956_send_command_p(const prog_char *cmd, size_t cmd_len,
+                           uint8_t *resp_buffer, size_t resp_buffer_size);
+
+// True once the response to the sent command starts to arrive
+bool rcs956_response_started(void);
 
-// Read response from RC-S956 or timeout
-bool rcs956_read_response(uint8_t *resp_buffer, size_t resp_buffer_size);
+// Wait for the response to the sent command or timeout
+bool rcs956_read_response(void);
 
 // Cancel a pending command via Ack
 void rcs956_cancel_cmd(void);
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Known state of the RC-S956, used to skip commands whose effect is
+ * already in place. Each command costs a frame, ACK and response round
+ * trip, and Reset another 15 ms of waiting, so skipping them shortens the
+ * switch between initiator and target mode.
+ *
+ * Nothing is known after power up. A Reset forgets everything but mode 0,
+ * which holds until a command other than configuration is sent, except a
+ * poll that finds no target. Commands that switch to target mode or DEP
+ * forget the registers and parameters. A timeout forgets everything, as
+ * the module may have been disconnected.
+ */
+
+#include <string.h>
+
+#include <avr/io.h>
+
+#include "rcs956_shadow.h"
+
+#define CMD 0xd4
+
+/* Configuration commands, which do not change the mode */
+#define GET_FIRMWARE_VERSION 0x02
+#define READ_REGISTER 0x06
+#define WRITE_REGISTER 0x08
+#define SET_PARAMETERS 0x12
+#define RF_CONFIG 0x32
+
+/* Commands that change the mode */
+#define IN_JUMP_FOR_PSL 0x46
+#define IN_LIST_PASSIVE_TARGET 0x4a
+#define IN_RELEASE 0x52
+#define IN_JUMP_FOR_DEP 0x56
+#define TG_INIT_TARGET 0x8c
+
+/* RFConfiguration item switching the RF field */
+#define RF_CONFIG_FIELD 0x01
+
+#define RF_CONFIG_ITEMS 6
+#define RF_CONFIG_BYTES 3
+#define REGISTER_SLOTS 2
+
+static bool __is_reset;
+static bool __is_reset_before_poll;
+static bool __has_target;
+
+static uint8_t __rf_config_valid;  /* bit per item */
+static uint8_t __rf_config[RF_CONFIG_ITEMS][RF_CONFIG_BYTES];
+
+static uint8_t __register_valid;  /* bit per slot */
+static uint16_t __register_adr[REGISTER_SLOTS];
+static uint8_t __register_val[REGISTER_SLOTS];
+static uint8_t __register_next;
+
+static bool __param_valid;
+static uint8_t __param;
+
+/*
+ * Forgets everything known about the module.
+ */
+void rcs956_shadow_invalidate(void)
+{
+  __is_reset = false;
+  __is_reset_before_poll = false;
+  __has_target = false;
+  __rf_config_valid = 0;
+  __register_valid = 0;
+  __param_valid = false;
+}
+
+/*
+ * Notes a command being sent. Any command but configuration may leave
+ * mode 0 and turn the RF field on. Mode changes may also reset the
+ * registers and parameters.
+ */
+void rcs956_shadow_command(const uint8_t *cmd)
+{
+  __is_reset_before_poll = false;
+  if (cmd[0] == CMD) {
+    switch (cmd[1]) {
+      case GET_FIRMWARE_VERSION:
+      case READ_REGISTER:
+      case WRITE_REGISTER:
+      case SET_PARAMETERS:
+      case RF_CONFIG:
+        return;
+      case IN_LIST_PASSIVE_TARGET:
+        __is_reset_before_poll = __is_reset;
+        __has_target = true;
+        break;
+      case IN_RELEASE:
+        __has_target = false;
+        break;
+      case IN_JUMP_FOR_PSL:
+      case IN_JUMP_FOR_DEP:
+      case TG_INIT_TARGET:
+        __has_target = false;
+        __register_valid = 0;
+        __param_valid = false;
+        break;
+    }
+  }
+  __is_reset = false;
+  __rf_config_valid &= ~_BV(RF_CONFIG_FIELD);
+}
+
+/*
+ * Notes that the last InListPassiveTarget found no target, which leaves
+ * the module in the mode it was in.
+ */
+void rcs956_shadow_no_target(void)
+{
+  __is_reset = __is_reset_before_poll;
+  __is_reset_before_poll = false;
+  __has_target = false;
+}
+
+bool rcs956_shadow_has_target(void)
+{
+  return __has_target;
+}
+
+/*
+ * Notes a successful Reset. The module is in mode 0, and nothing else is
+ * assumed to have survived.
+ */
+void rcs956_shadow_set_reset(void)
+{
+  rcs956_shadow_invalidate();
+  __is_reset = true;
+}
+
+bool rcs956_shadow_is_reset(void)
+{
+  return __is_reset;
+}
+
+bool rcs956_shadow_has_rf_config(uint8_t item, const uint8_t *settings,
+                                 uint8_t len)
+{
+  return (item < RF_CONFIG_ITEMS && len <= RF_CONFIG_BYTES &&
+          (__rf_config_valid & _BV(item)) &&
+          memcmp(__rf_config[item], settings, len) == 0);
+}
+
+void rcs956_shadow_set_rf_config(uint8_t item, const uint8_t *settings,
+                                 uint8_t len)
+{
+  if (item < RF_CONFIG_ITEMS && len <= RF_CONFIG_BYTES) {
+    memcpy(__rf_config[item], settings, len);
+    __rf_config_valid |= _BV(item);
+  }
+}
+
+bool rcs956_shadow_has_register(uint16_t adr, uint8_t val)
+{
+  uint8_t i;
+
+  for (i = 0; i < REGISTER_SLOTS; i++) {
+    if ((__register_valid & _BV(i)) && __register_adr[i] == adr) {
+      return __register_val[i] == val;
+    }
+  }
+  return false;
+}
+
+/*
+ * Remembers a register value, replacing the oldest slot if the register
+ * has none.
+ */
+void rcs956_shadow_set_register(uint16_t adr, uint8_t val)
+{
+  uint8_t i;
+
+  for (i = 0; i < REGISTER_SLOTS; i++) {
+    if ((__register_valid & _BV(i)) && __register_adr[i] == adr) {
+      break;
+    }
+  }
+  if (i == REGISTER_SLOTS) {
+    i = __register_next;
+    __register_next = (__register_next + 1) % REGISTER_SLOTS;
+  }
+  __register_adr[i] = adr;
+  __register_val[i] = val;
+  __register_valid |= _BV(i);
+}
+
+bool rcs956_shadow_has_param(uint8_t flags)
+{
+  return __param_valid && __param == flags;
+}
+
+void rcs956_shadow_set_param(uint8_t flags)
+{
+  __param = flags;
+  __param_valid = true;
+}
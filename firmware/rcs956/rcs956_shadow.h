@@ -0,0 +1,59 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Known state of the RC-S956, used to skip commands whose effect is
+ * already in place. Everything is forgotten on reset and on timeout,
+ * registers and parameters also on switching to target mode or DEP.
+ */
+
+#ifndef __RCS956_SHADOW_H__
+#define __RCS956_SHADOW_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Forgets everything known about the module
+void rcs956_shadow_invalidate(void);
+
+// Notes a command being sent; all but configuration may change the mode
+void rcs956_shadow_command(const uint8_t *cmd);
+
+// Notes that the last InListPassiveTarget found no target
+void rcs956_shadow_no_target(void);
+
+// True if targets found by InListPassiveTarget may still be listed
+bool rcs956_shadow_has_target(void);
+
+// Notes a successful Reset: mode 0, nothing else known
+void rcs956_shadow_set_reset(void);
+
+// True if the module has stayed in mode 0 since the last Reset
+bool rcs956_shadow_is_reset(void);
+
+// RFConfiguration item with up to 3 setting bytes
+bool rcs956_shadow_has_rf_config(uint8_t item, const uint8_t *settings,
+                                 uint8_t len);
+void rcs956_shadow_set_rf_config(uint8_t item, const uint8_t *settings,
+                                 uint8_t len);
+
+// Register written with WriteRegister
+bool rcs956_shadow_has_register(uint16_t adr, uint8_t val);
+void rcs956_shadow_set_register(uint16_t adr, uint8_t val);
+
+// Flags set with SetParameters
+bool rcs956_shadow_has_param(uint8_t flags);
+void rcs956_shadow_set_param(uint8_t flags);
+
+#endif /* !__RCS956_SHADOW_H__ */
@@ -28,9 +28,9 @@
 
 #include "rcs956_common.h"
 #include "rcs956_protocol.h"
-#include "../peripheral/lcd.h"
+#include "rcs956_shadow.h"
+#include "../peripheral/log.h"
 #include "../peripheral/power_down.h"
-#include "../peripheral/usart.h"
 
 #include "rcs956_target.h"
 
@@ -44,27 +44,32 @@ bool rcs956_write_register(uint16_t adr, uint8_t val)
   uint8_t resp[MAX_RECV_SIZE];
   uint8_t cmd[MAX_SEND_SIZE];
 
+  if (rcs956_shadow_has_register(adr, val)) {
+    return true;
+  }
+
   memcpy_P(cmd, __cmd, sizeof(__cmd));
   cmd[sizeof(__cmd)] = H8(adr);
   cmd[sizeof(__cmd)+1] = L8(adr);
   cmd[sizeof(__cmd)+2] = val;
 
-  if (!rcs956_send_command(cmd, sizeof(__cmd)+3)) {
-    lcd_printf(0, "wreg %x fail", adr);
+  if (!rcs956_send_command(cmd, sizeof(__cmd)+3, resp, sizeof(resp))) {
+    log_printf(LOG_ERROR, 0, "wreg %x fail", adr);
     return false;
   }
 
-  if (!rcs956_read_response(resp, sizeof(resp))) {
-    lcd_printf(0, "wreg rs fail %d %02X", resp[3], resp[5]);
+  if (!rcs956_read_response()) {
+    log_printf(LOG_ERROR, 0, "wreg rs fail %d %02X", resp[3], resp[5]);
     return false;
   }
 
   if (resp[7] != 0x00) {
-    lcd_printf(0, "wreg fail %02X", resp[7]);
+    log_printf(LOG_ERROR, 0, "wreg fail %02X", resp[7]);
     protocol_errno = UNEXPECTED_REPLY;
     return false;
   }
 
+  rcs956_shadow_set_register(adr, val);
   return true;
 }
 
@@ -80,26 +85,32 @@ bool rcs956_set_param(uint8_t flags)
   uint8_t resp[MAX_RECV_SIZE];
   uint8_t cmd[MAX_SEND_SIZE];
 
+  if (rcs956_shadow_has_param(flags)) {
+    return true;
+  }
+
   memcpy_P(cmd, __cmd, sizeof(__cmd));
   cmd[sizeof(__cmd)] = flags;
 
-  if (!rcs956_send_command(cmd, sizeof(__cmd)+1)) {
+  if (!rcs956_send_command(cmd, sizeof(__cmd)+1, resp, sizeof(resp))) {
     return false;
   }
 
-  if (!rcs956_read_response(resp, sizeof(resp))) {
-    lcd_printf(0, "sp rs fail %d %02X", resp[3], resp[5]);
+  if (!rcs956_read_response()) {
+    log_printf(LOG_ERROR, 0, "sp rs fail %d %02X", resp[3], resp[5]);
     return false;
   }
 
+  rcs956_shadow_set_param(flags);
   return true;
 }
 
 /*
  * Set the RC-S620 into target mode, ready to receive data from
- * an initiator.
+ * an initiator. The activation by the initiator goes to resp; wait for it
+ * with rcs956_tg_wait_initiator.
  */
-int rcs956_tg_init(const uint8_t idm[])
+int rcs956_tg_init(const uint8_t idm[], uint8_t *resp, size_t resp_len)
 {
   static const prog_char __cmd_prefix[] = {
     0xd4, 0x8c,
@@ -131,33 +142,34 @@ int rcs956_tg_init(const uint8_t idm[])
   memset(&cmd[cmd_len], 0x00, 10);
   cmd_len += 10;
 
-  if (!rcs956_send_command(cmd, cmd_len)) {
-    lcd_printf(0, "tgi send fail %i", protocol_errno);
+  if (!rcs956_send_command(cmd, cmd_len, resp, resp_len)) {
+    log_printf(LOG_ERROR, 0, "tgi send fail %i", protocol_errno);
     return 0;
   }
-  lcd_printf(0, "tgi sent");
+  log_printf(LOG_DEBUG, 0, "tgi sent");
   return 1;
 }
 
 /*
- * Waits for initiator to connect to RC-S620.
+ * Waits for initiator to connect to RC-S620, into the resp buffer passed to
+ * rcs956_tg_init.
  *
  * Returns: 1 on success, -1 on timeout, 0 on fail
  */
-int rcs956_tg_wait_initiator(uint8_t *resp, size_t resp_len)
+int rcs956_tg_wait_initiator(void)
 {
   uint8_t count;
   // Loop because max sleep time on 8 bit timer is less than needed
   for (count = 0; count < SLEEP_COUNT(TG_INIT_WAIT_MS); count++) {
-    // Wake up on data (USART interrupt) or time out (Timer interrupt)
-    sleep_until_timer(SLEEP_MODE_IDLE, false);
-    if (usart_has_data()) {
-      if (!rcs956_read_response(resp, resp_len)) {
-        lcd_printf(0, "tgi resp fail %d", resp[3]);
+    if (rcs956_response_started()) {
+      if (!rcs956_read_response()) {
+        log_printf(LOG_ERROR, 0, "tgi resp fail %i", protocol_errno);
         return 0;
       }
       return 1;
     }
+    // Wake up on data (USART interrupt) or time out (Timer interrupt)
+    sleep_until_timer(SLEEP_MODE_IDLE, false);
   }
   rcs956_serial_wake_up(); // NFC Module may be powered down
   rcs956_cancel_cmd();
@@ -182,18 +194,19 @@ bool rcs956_tg_set_general_bytes(uint8_t *payload, size_t payload_len)
   memcpy_P(cmd, __cmd, sizeof(__cmd));
   memcpy(&cmd[2], payload, payload_len);
 
-  if (!rcs956_send_command(cmd, cmd_len)) {
-    lcd_printf(0, "tsgb send fail");
+  if (!rcs956_send_command(cmd, cmd_len, resp, sizeof(resp))) {
+    log_printf(LOG_ERROR, 0, "tsgb send fail");
     return false;
   }
 
-  if (!rcs956_read_response(resp, sizeof(resp))) {
-    lcd_printf(0, "sgb rs fail %d %02X", resp[OFS_DATA_LEN], resp[5]);
+  if (!rcs956_read_response()) {
+    log_printf(LOG_ERROR, 0, "sgb rs fail %d %02X", resp[OFS_DATA_LEN],
+               resp[5]);
     return false;
   }
 
   if (resp[OFS_DATA] != 0x00) {
-    lcd_printf(0, "tsgb st fail %02X", resp[OFS_DATA]);
+    log_printf(LOG_ERROR, 0, "tsgb st fail %02X", resp[OFS_DATA]);
     protocol_errno = UNEXPECTED_REPLY;
     return false;
   } else {
@@ -208,14 +221,14 @@ bool rcs956_tg_set_general_bytes(uint8_t *payload, size_t payload_len)
 int rcs956_tg_get_dep_data(uint8_t *resp, size_t resp_len)
 {
   static const prog_char __cmd[] = {0xd4, 0x86};
-  if (!rcs956_send_command_p(__cmd, sizeof(__cmd))) {
-    lcd_printf(0, "getdep tx fail");
+  if (!rcs956_send_command_p(__cmd, sizeof(__cmd), resp, resp_len)) {
+    log_printf(LOG_ERROR, 0, "getdep tx fail");
     return 0;
   }
 
-  if (!rcs956_read_response(resp, resp_len)) {
-    lcd_printf(0, "getdep rx fail %d", resp[OFS_DATA_LEN]);
-    lcd_printf(1, "err %i", protocol_errno);
+  if (!rcs956_read_response()) {
+    log_printf(LOG_ERROR, 0, "getdep rx fail %d", resp[OFS_DATA_LEN]);
+    log_printf(LOG_ERROR, 1, "err %i", protocol_errno);
     return 0;
   }
   // TODO: if bit 6 of status is set, re-execute (chaining)
@@ -242,14 +255,14 @@ bool rcs956_tg_set_dep_data(uint8_t *data, size_t data_len, uint8_t *status)
   memcpy_P(cmd, __cmd, sizeof(__cmd));
   memcpy(&cmd[2], data, data_len);
 
-  if (!rcs956_send_command(cmd, data_len + 2)) {
-    lcd_printf(0, "setdep tx fail");
+  if (!rcs956_send_command(cmd, data_len + 2, resp, sizeof(resp))) {
+    log_printf(LOG_ERROR, 0, "setdep tx fail");
     return false;
   }
 
-  if (!rcs956_read_response(resp, sizeof(resp))) {
-    lcd_printf(0, "setdep rx fail %d", resp[OFS_DATA_LEN]);
-    lcd_print_hex(1, resp, 8);
+  if (!rcs956_read_response()) {
+    log_printf(LOG_ERROR, 0, "setdep rx fail %d", resp[OFS_DATA_LEN]);
+    log_hex(LOG_ERROR, 1, resp, 8);
     return false;
   }
   *status = resp[OFS_DATA];
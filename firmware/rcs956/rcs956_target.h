@@ -28,8 +28,8 @@
 #define TG_INIT_WAIT_MS 500
 
 /* target mode (mode 0, 1, 2, 3) */
-int rcs956_tg_init(const uint8_t idm[]);
-int rcs956_tg_wait_initiator(uint8_t *resp, size_t resp_len);
+int rcs956_tg_init(const uint8_t idm[], uint8_t *resp, size_t resp_len);
+int rcs956_tg_wait_initiator(void);
 bool rcs956_tg_set_general_bytes(uint8_t *payload, size_t payload_len);
 
 /* Felica target (mode 5) */
@@ -32,17 +32,72 @@
 #include "nfc_url2.h"
 #include "melodies.h"
 #include "nfc/sp.h"
-#include "peripheral/lcd.h"
+#include "peripheral/log.h"
 #include "peripheral/power_down.h"
 #include "peripheral/sound.h"
 #include "peripheral/three_wire.h"
+#include "peripheral/usart.h"
+#include "nfc/type3tag.h"
+#include "poll_schedule.h"
 #include "rcs926/rcs926.h"
+#include "trace.h"
 
-static bool make_url(uint8_t *buf, uint8_t buf_size,
-                     __attribute__((unused)) void* extra) {
-  return build_url((char *)buf, buf_size, NULL);
+static uint8_t make_url(uint8_t *buf, uint8_t buf_size, uint8_t skip,
+                        __attribute__((unused)) void* extra) {
+  return build_url_tail((char *)buf, buf_size, NULL, skip);
 }
 
+// The record being served and the next one. The next record is built
+// once the served one has been read in full, so each URL counter goes to
+// a completed read and block reads never wait on crypto.
+static uint8_t ndef[2][128];
+static uint8_t ndef_len[2];
+static uint8_t served;
+static bool has_next = false;
+
+/*
+ * Builds a smart poster with a new URL counter into the buffer that is
+ * not being served.
+ */
+static void build_next_ndef(void)
+{
+  uint8_t next = served ^ 1;
+
+  ndef_len[next] = smart_poster(ndef[next], sizeof(ndef[next]), NULL,
+                                URL, &make_url, NULL);
+  log_printf(LOG_INFO, 0, "URL %iB %i blk", ndef_len[next],
+             NUM_BLOCKS(ndef_len[next]));
+  has_next = true;
+}
+
+/*
+ * Serves the record built last, if any; otherwise the unread one stays.
+ * Called when an RF field appears, before the reader sends any command.
+ */
+static void swap_ndef(void)
+{
+  if (has_next) {
+    served ^= 1;
+    has_next = false;
+  }
+}
+
+#ifdef WITH_TRACE
+/*
+ * Sends the trace of the touch over the USART, which is only on while
+ * sending.
+ */
+static void dump_trace(void)
+{
+  usart_init();
+  trace_dump();
+  usart_disable();
+  trace_clear();
+}
+#else /* !WITH_TRACE */
+#define dump_trace()
+#endif /* WITH_TRACE */
+
 static void sleep_until_melody_completes(void)
 {
   set_sleep_mode(SLEEP_MODE_IDLE);
@@ -57,36 +112,39 @@ static void sleep_until_melody_completes(void)
  * Main routine to emulate a Type 3 tag.
  */
 int main() {
-  uint8_t ndef[128];
-  uint8_t ndef_len;
-
   twspi_init();
   _delay_ms(100);
 
-  ndef_len = smart_poster(ndef, sizeof(ndef), NULL, &make_url, NULL);
-
   lcd_init();
-  lcd_puts(0, "Felica Plug");
-  lcd_printf(0, "URL %iB", ndef_len);
+  log_puts(LOG_INFO, 0, "Felica Plug");
 
   beep_n_times(2);
   sleep_until_melody_completes();
 
   disable_unused_circuits();
 
+  // The first record; the others are built after each completed read
+  build_next_ndef();
+
   for (;;) {
-    lcd_puts(0, "suspend");
+    log_puts(LOG_DEBUG, 0, "suspend");
     // Wake up if RF field detected
     rcs926_wake_up_on_rf(true);
     rcs926_wake_up_on_irq(false);
     rcs926_suspend();
-    // RF detect will wake up
-    sleep_forever();
+    // RF detect will wake up; checked again with interrupts off, as the
+    // field may come up after this check
+    if (!rcs926_rf_present()) {
+      lcd_update();
+      (void)sleep_forever_unless(rcs926_rf_present);
+    }
 
     // If there is not RF, go back to sleep
     if (rcs926_rf_present()) {
+      swap_ndef();
+      trace(TRACE_TARGET_START, 0);
       // Wake up Plug
-      lcd_puts(0, "resume");
+      log_puts(LOG_DEBUG, 0, "resume");
       rcs926_resume();
       rcs926_init();
       // Configure to wake up on data ready (IRQ)
@@ -100,22 +158,27 @@ int main() {
 
         // If we have data, process the command
         if (rcs926_data_ready()) {
-          lcd_printf(0, "counter %i", TCNT2);
+          log_printf(LOG_DEBUG, 0, "counter %i", TCNT2);
           loop = 1;
           bool has_read_all = false;
-          rcs926_process_command(ndef, ndef_len, &has_read_all);
+          rcs926_process_command(ndef[served], ndef_len[served],
+                                 &has_read_all);
           if (has_read_all) {
+            trace(TRACE_TOUCH, TOUCH_TYPE3);
             play_melody(melody_googlenfc001,
                         sizeof(melody_googlenfc001) / sizeof(struct note));
+            // Build the next record while the melody plays
+            build_next_ndef();
             sleep_until_melody_completes();
-            lcd_puts(0, "success");
+            log_puts(LOG_INFO, 0, "success");
+            dump_trace();
             // Melody is long enough to complete transfer. Go back to sleep.
             break;
           }
         } else {
           // Time out, give it another chance
           --loop;
-          lcd_printf(0, "timeout %i", TCNT2);
+          log_printf(LOG_INFO, 0, "timeout %i", TCNT2);
         }
       } while (loop);
     }
@@ -28,18 +28,20 @@
 #include "melodies.h"
 #include "peripheral/battery.h"
 #include "peripheral/eeprom.h"
-#include "peripheral/lcd.h"
+#include "peripheral/log.h"
 #include "peripheral/led.h"
 #include "peripheral/module_power.h"
 #include "peripheral/power_down.h"
 #include "peripheral/switch.h"
+#include "poll_schedule.h"
 #include "rcs956/rcs956_common.h"
 #include "rcs956/rcs956_initiator.h"
 #include "rcs956/rcs956_protocol.h"
 #include "target.h"
+#include "trace.h"
 
 
-// Milliseconds delay between polling. Rough time for one main loop.
+// Rough time for one main loop without the idle time between polls.
 #define SLEEP_AFTER_TIMEOUT 500
 
 // Converts seconds into number of main loop iterations.
@@ -50,9 +52,6 @@
 #define PUSH_URL_LABEL_ENGLISH "Google Place"
 #define WATCHDOG_TIMEOUT WDTO_4S
 
-// How many times to retry after seeing an initiator
-#define TARGET_MODE_RETRY 10
-
 // Battery options
 #define CHECK_BATT_EVERY_NSECS 3600 /* beep on low battery once / hour */
 #define CHECK_BATT_ONCE_AFTER_SECS 2 /* beep on low battery after power up */
@@ -117,8 +116,8 @@ static void print_idle(void)
   uint8_t station_id[STATION_ID_BYTES];
 
   eeprom_read_station_id(station_id);
-  lcd_puts(0, "Base Station");
-  lcd_print_hex(1, station_id, sizeof(station_id));
+  log_puts(LOG_INFO, 0, "Base Station");
+  log_hex(LOG_INFO, 1, station_id, sizeof(station_id));
 }
 #else /* !HAS_LCD */
 #define print_idle()
@@ -161,26 +160,118 @@ static void play_url_push_success_song_and_wait(void)
   }
 }
 
-#ifndef WITH_TARGET
+/*
+ * Sleeps for the interval chosen by the poll scheduler with the RF field
+ * off. Long stretches use the slower clocked-down timer.
+ */
 static void sleep_after_timeout(void)
 {
+  uint16_t ms = poll_schedule_interval_ms();
+
   watchdog_reset();
+  if (ms == 0) {
+    return;
+  }
   rcs956_rf_off();
 
-  // Active sleep if blinking, deep sleep otherwise.
-  for (uint8_t i = 0; i < SLEEP_COUNT_CLK_DOWN(SLEEP_AFTER_TIMEOUT); i++) {
+  while (ms >= SLEEP_MS_CLK_DOWN) {
     sleep_until_timer(SLEEP_MODE_PWR_SAVE, true);
+    watchdog_reset();
+    ms -= SLEEP_MS_CLK_DOWN;
+  }
+  while (ms >= SLEEP_MS) {
+    sleep_until_timer(SLEEP_MODE_PWR_SAVE, false);
+    ms -= SLEEP_MS;
   }
 }
-#endif /* ! WITH_TARGET */
+
+/*
+ * Counts a completed touch. Trace builds hold the trace if the touch
+ * took TRACE_SLOW_TOUCH_MS or more since start_event; the main loop
+ * saves it to EEPROM once idle, as that takes a few hundred ms.
+ */
+static void touch_done(enum touch_kind kind,
+                       __attribute__((unused)) uint8_t start_event)
+{
+  poll_schedule_touch(kind);
+  trace(TRACE_TOUCH, kind);
+#ifdef WITH_TRACE
+  if (trace_ms_since(start_event) >= TRACE_SLOW_TOUCH_MS) {
+    trace_hold();
+  }
+#endif /* WITH_TRACE */
+}
+
+/*
+ * Polls for a Felica phone and pushes the URL.
+ * Returns true if the URL was pushed.
+ */
+static bool initiator_window(void)
+{
+  // initiator exits after polling times out (false) or URL is pushed (true)
+  if (!initiator(PUSH_URL_LABEL)) {
+    return false;
+  }
+  touch_done(TOUCH_FELICA_PUSH, TRACE_POLL_START);
+  log_puts(LOG_INFO, 0, "PUSH SLEEP");
+  play_url_push_success_song_and_wait();
+  return true;
+}
+
+#ifdef WITH_TARGET
+/*
+ * Waits as target until an initiator has read the data, gives up or
+ * does not show up. Leaves the module reset.
+ * Returns true if an initiator was seen.
+ */
+static bool target_window(void)
+{
+  enum touch_kind kind;
+  bool seen = false;
+  uint8_t retries = poll_schedule_target_retries();
+  uint8_t loop;
+
+  // Loop here to not skip watchdog timer
+  for (loop = 0; loop < retries; loop++) {
+    watchdog_reset();
+    // Targets left listed by the initiator are released, which needs no
+    // reset unless it fails. Otherwise reset, which is skipped if still in
+    // mode 0. A retry follows an activation, which only a reset clears.
+    if (loop > 0 || !rcs956_in_release()) {
+      (void)rcs956_reset();
+    }
+    trace(TRACE_TARGET_START, 0);
+    enum target_res res = target(PUSH_URL_LABEL_ENGLISH, &kind);
+    trace(TRACE_TARGET_END, res);
+    if (res == TGT_COMPLETE || res == TGT_RETRY) {
+      seen = true;
+    }
+    if (res == TGT_COMPLETE) {
+      touch_done(kind, TRACE_TARGET_START);
+      led_off();
+      play_url_push_success_song_and_wait();
+      break;
+    } else if (res == TGT_TIMEOUT || res == TGT_ERROR) {
+      break;
+    } // loop on TGT_RETRY
+  }
+  led_off();
+  (void)rcs956_reset();
+  return seen;
+}
+#endif /* WITH_TARGET */
 
 // Let voltage settle before first check
 static int batt_check_counter = SECS2COUNT(CHECK_BATT_ONCE_AFTER_SECS);
 
-// Beep and blink every once in a while if battery is low
+// Beep and blink every once in a while if battery is low. Also saves
+// the polling weights, which need not survive a reset exactly.
 static void low_battery_check(void)
 {
-  if (--batt_check_counter == 0) {
+  // Count the idle time between polls as main loops, too
+  batt_check_counter -= 1 + poll_schedule_interval_ms() / SLEEP_AFTER_TIMEOUT;
+  if (batt_check_counter <= 0) {
+    poll_schedule_save();
     adc_init();
     uint8_t voltage = read_voltage();
     adc_disable();
@@ -223,6 +314,7 @@ int main(void)
 
   lcd_init();
   print_idle();
+  lcd_update();
 
   // Initialize and self-test
   module_power_up();
@@ -238,6 +330,9 @@ int main(void)
     beep_n_times_and_wait(3);
     sleep_forever();
   }
+  load_station_info();
+  eeprom_load_stats();
+  poll_schedule_load();
   if (is_on_external_power()) {
     play_song_and_wait(melody_start_up_external,
                        sizeof(melody_start_up_external) / sizeof(struct note));
@@ -250,35 +345,38 @@ int main(void)
   watchdog_start();
 
   for (;;) {
+    bool touched = false;
+
     watchdog_reset();
-    // initiator exits after polling times out (false) or URL is pushed (true)
-    if (initiator(PUSH_URL_LABEL)) {
-      lcd_puts(0, "PUSH SLEEP");
-      play_url_push_success_song_and_wait();
-    }
 #ifdef WITH_TARGET
-    uint8_t loop;
-    // Loop here to not skip watchdog timer
-    for (loop = 0; loop < TARGET_MODE_RETRY; loop++) {
-      watchdog_reset();
-      (void)rcs956_reset();
-      enum target_res res = target(PUSH_URL_LABEL_ENGLISH);
-      if (res == TGT_COMPLETE) {
-        led_off();
-        play_url_push_success_song_and_wait();
-        break;
-      } else if (res == TGT_TIMEOUT || res == TGT_ERROR) {
-        break;
-      } // loop on TGT_RETRY
+    bool run_initiator = poll_schedule_run_initiator();
+    bool run_target = poll_schedule_run_target();
+
+    if (poll_schedule_target_first()) {
+      touched |= run_target && target_window();
+      touched |= run_initiator && initiator_window();
+    } else {
+      touched |= run_initiator && initiator_window();
+      touched |= run_target && target_window();
     }
-    led_off();
-    (void)rcs956_reset();
+    poll_schedule_update(touched);
     low_battery_check();
 #else /* !WITH_TARGET */
+    touched = initiator_window();
+    poll_schedule_update(touched);
     // Check battery level while RF field is still on
     low_battery_check();
-    sleep_after_timeout();
 #endif /* WITH_TARGET */
+    set_poll_url_data(poll_schedule_interval_ms(),
+                      poll_schedule_target_retries());
+    eeprom_write_back_stats();
+    lcd_update();
+#ifdef WITH_TRACE
+    if (trace_held()) {
+      trace_save();
+    }
+#endif /* WITH_TRACE */
+    sleep_after_timeout();
 
     // Reconfigure Felica module if communication timed out,
     // e.g. due to temporary disconnect.
@@ -25,12 +25,13 @@
 #include <util/delay.h>
 
 #include "eeprom_data.h"
+#include "histogram.h"
 #include "nfc/llcp.h"
 #include "nfc/npp.h"
 #include "nfc/snep.h"
 #include "nfc/sp.h"
 #include "nfc/type3tag.h"
-#include "peripheral/lcd.h"
+#include "peripheral/log.h"
 #include "peripheral/led.h"
 #include "peripheral/timer.h"
 #include "rcs956/rcs956_protocol.h"
@@ -41,9 +42,9 @@
 #include "target.h"
 
 // Adapter method to pass URL making to Smart Poster
-static bool get_url(uint8_t *buf, uint8_t buf_size,
+static uint8_t get_url(uint8_t *buf, uint8_t buf_size, uint8_t skip,
              __attribute__((unused)) void* extra) {
-  return build_url((char *)buf, buf_size, NULL);
+  return build_url_tail((char *)buf, buf_size, NULL, skip);
 }
 
 /*
@@ -65,11 +66,13 @@ static bool get_url(uint8_t *buf, uint8_t buf_size,
  *   resp_len - Size of resp in bytes
  *   ndef - Data to send to peer, e.g. a NDEF record
  *   ndef_len - Length of payload in bytes
+ *   kind - Set to TOUCH_SNEP or TOUCH_NPP on success
  *
  * Returns:
  *   true if all data was passed to peer, false on error or timeout
  */
-bool llcp_service(uint8_t *resp, int resp_len, uint8_t ndef[], int ndef_len)
+bool llcp_service(uint8_t *resp, int resp_len, uint8_t ndef[], int ndef_len,
+                  enum touch_kind *kind)
 {
   uint8_t cmd[160];
   uint8_t cmd_len;
@@ -90,7 +93,7 @@ bool llcp_service(uint8_t *resp, int resp_len, uint8_t ndef[], int ndef_len)
 
     // Quit if Status not OK
     if (resp[OFS_DATA] != 0 || resp[OFS_DATA_LEN] < 5) {
-      lcd_printf(1, "Status %x", resp[OFS_DATA]);
+      log_printf(LOG_ERROR, 1, "Status %x", resp[OFS_DATA]);
       return false;
     }
 
@@ -131,6 +134,7 @@ bool llcp_service(uint8_t *resp, int resp_len, uint8_t ndef[], int ndef_len)
       rcs956_tg_set_dep_data(cmd, cmd_len, &status);
     }
   } while (context.state != LLCP_DONE && --loop_count);
+  *kind = snep ? TOUCH_SNEP : TOUCH_NPP;
   return success;
 }
 
@@ -168,7 +172,7 @@ bool felica_service(uint8_t *resp, int resp_len,
         return false;
       }
       if (resp[7] == 0x31) {
-        lcd_printf(0, "closed");
+        log_printf(LOG_DEBUG, 0, "closed");
         return false;
       }
     }
@@ -184,8 +188,9 @@ bool felica_service(uint8_t *resp, int resp_len,
  * Can leave LED on to avoid flickering. Main program should turn led
  * off as appropriate.
  *
- * Argument:
+ * Arguments:
  *      label: Label of the NFC type 3 tag (Text record).
+ *      kind: Set to the kind of touch on TGT_COMPLETE.
  *
  * Returns:
  *      TGT_COMPLETE initiator detected and all data read
@@ -193,7 +198,7 @@ bool felica_service(uint8_t *resp, int resp_len,
  *      TGT_RETRY a tag was found, but info not read or unknown type
  *      TGT_ERROR communication error with RC-S620
  */
-enum target_res target(char *label)
+enum target_res target(char *label, enum touch_kind *kind)
 {
   uint8_t resp[128];
   uint8_t card_idm[8];
@@ -217,18 +222,22 @@ enum target_res target(char *label)
   }
 
   // (4) Put Pasori into target mode with specified ID's
-  if (rcs956_tg_init(card_idm) != 1) {
+  if (rcs956_tg_init(card_idm, resp, sizeof(resp)) != 1) {
     return TGT_ERROR;
   }
 
-  if (rcs956_tg_wait_initiator(resp, sizeof(resp)) != 1) {
+  // Encrypt ahead while waiting for an initiator
+  precompute_url();
+
+  if (rcs956_tg_wait_initiator() != 1) {
     return TGT_TIMEOUT;
   }
 
   // We see an initiator of any kind: give user feedback
+  start_timer(TIMER_RES_1ms);
   led_on();
   play_melody(melody_click, sizeof(melody_click) / sizeof(struct note));
-  lcd_printf(1, "actv mode %02x", resp[OFS_DATA]);
+  log_printf(LOG_DEBUG, 1, "actv mode %02x", resp[OFS_DATA]);
   uint8_t target_type = resp[OFS_DATA] & 0x03; // Target type
 
   // (5) Turn off target optimization for 106kbps
@@ -253,7 +262,7 @@ enum target_res target(char *label)
       if (!rcs956_tg_set_general_bytes(gen_bytes, len)) {
         return false;
       }
-      lcd_puts(1, "llcp");
+      log_puts(LOG_DEBUG, 1, "llcp");
     } else {
       if (!rcs956_tg_set_general_bytes(NULL, 0)) {
         return false;
@@ -274,7 +283,7 @@ enum target_res target(char *label)
       if (!rcs956_comm_thru_ex(cmd, 4, resp, sizeof(resp), false)) {
         return TGT_ERROR;
       }
-      lcd_puts(1, "RLS_REQ");
+      log_puts(LOG_DEBUG, 1, "RLS_REQ");
       return TGT_RETRY;
   }
 
@@ -283,24 +292,29 @@ enum target_res target(char *label)
     uint8_t sp[128]; /* maximum tag size is hopefully less than 80 bytes */
     uint8_t sp_len;
     bool success = false;
-    sp_len = smart_poster(sp, sizeof(sp), label, get_url, NULL);
-    lcd_printf(1, "sp len %i", sp_len);
-    start_timer(TIMER_RES_1ms);
+    sp_len = smart_poster(sp, sizeof(sp), label, URL, get_url, NULL);
+    log_printf(LOG_DEBUG, 1, "sp len %i %i blk", sp_len, NUM_BLOCKS(sp_len));
+    unsigned int service_start = get_timer();
     if (target_type == 1) { // LLCP ISO18092
-      success = llcp_service(resp, sizeof(resp), sp, sp_len);
+      success = llcp_service(resp, sizeof(resp), sp, sp_len, kind);
     } else if (target_type == 2) { // Felica
       success = felica_service(resp, sizeof(resp), sp, sp_len, card_idm);
+      *kind = TOUCH_TYPE3;
     }
     stop_timer();
     if (success) {
-      lcd_printf(1, "type %i OK %i ms", target_type, get_timer());
+      histogram_add(HIST_TOUCH_TO_PUSH, get_timer());
+      if (target_type == 1) {
+        histogram_add(HIST_LLCP_SESSION, get_timer() - service_start);
+      }
+      log_printf(LOG_INFO, 1, "type %i OK %i ms", target_type, get_timer());
       return TGT_COMPLETE;
     } else {
-      lcd_printf(1, "type %i retry", target_type);
+      log_printf(LOG_INFO, 1, "type %i retry", target_type);
       return TGT_RETRY;
     }
   } else {
-    lcd_printf(1, "type %d retry", target_type);
+    log_printf(LOG_INFO, 1, "type %d retry", target_type);
     // give the initiator a chance to try another mode
     return TGT_RETRY;
   }
@@ -21,12 +21,15 @@
 #ifndef __TARGET_H__
 #define __TARGET_H__
 
+#include "poll_schedule.h"
+
 #define TG_COMM_TIMEOUT_MS 512
 #define MAX_TARGET_LOOP_TIMES 16
 
 enum target_res { TGT_COMPLETE, TGT_TIMEOUT, TGT_ERROR, TGT_RETRY };
 
-// Switch into target mode and respond to Felica or ISO 18092 requests
-enum target_res target(char* label);
+// Switch into target mode and respond to Felica or ISO 18092 requests.
+// Sets kind to the kind of touch that completed.
+enum target_res target(char* label, enum touch_kind *kind);
 
 #endif /* !__TARGET_H__ */
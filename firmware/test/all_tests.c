@@ -31,9 +31,21 @@ void avr_sha1_test(void);
 void ws_base_64_enc_test(void);
 
 void felica_push_test(void);
+void histogram_test(void);
 void llcp_test(void);
+void nfc_url2_test(void);
+void poll_schedule_test(void);
+void rcs956_frame_test(void);
+void rcs956_shadow_test(void);
+void sp_test(void);
+void three_wire_test(void);
+void trace_test(void);
 
 void eeprom_test(void);
+#ifndef __AVR__
+// Needs the host EEPROM simulation
+void eeprom_counter_test(void);
+#endif
 
 int main() {
   test_init();
@@ -43,9 +55,20 @@ int main() {
   ws_base_64_enc_test();
 
   felica_push_test();
+  histogram_test();
   llcp_test();
+  nfc_url2_test();
+  poll_schedule_test();
+  rcs956_frame_test();
+  rcs956_shadow_test();
+  sp_test();
+  three_wire_test();
+  trace_test();
 
   eeprom_test();
+#ifndef __AVR__
+  eeprom_counter_test();
+#endif
 
   success();
   return 0;  // unreachable
@@ -22,6 +22,7 @@
 #include <string.h>
 
 #include "../crypto/avr_aes_enc.h"
+#include "../enc.h"
 
 #include "../peripheral/lcd.h"
 #include "../peripheral/timer.h"
@@ -71,7 +72,135 @@ static void test_vector_gladman() {
   assert(memcmp(buffer, expected, 16) == 0);
 }
 
+#ifdef WITH_AES_ASM
+/*
+ * Cycle count of the assembly version against the C version on the same
+ * block. Both must produce the same cipher text.
+ */
+static void test_asm_vs_c() {
+  test("asm_vs_c");
+  aes128_ctx_t ctx;
+  uint8_t key[] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+  uint8_t buffer_asm[16];
+  uint8_t buffer_c[16];
+  uint16_t cycles_asm, cycles_c;
+  uint8_t i;
+
+  aes128_init(key, &ctx);
+  for (i = 0; i < 16; i++) {
+    buffer_asm[i] = buffer_c[i] = i * 17;
+  }
+  start_timer(TIMER_RES_CLOCK);
+  aes128_enc(buffer_asm, &ctx);
+  stop_timer();
+  cycles_asm = get_timer();
+  start_timer(TIMER_RES_CLOCK);
+  aes128_enc_c(buffer_c, &ctx);
+  stop_timer();
+  cycles_c = get_timer();
+  lcd_printf(0, "asm %u c %u", cycles_asm, cycles_c);
+  assert(memcmp(buffer_asm, buffer_c, 16) == 0);
+  assert(cycles_asm < cycles_c);
+}
+#endif /* WITH_AES_ASM */
+
+static void test_enc_cached_key() {
+  test("enc_cached_key");
+  uint8_t key[] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+  uint8_t counter[] = { 0x32, 0x43, 0xf6, 0xa8, 0x88, 0x5a, 0x30, 0x8d,
+                        0x31, 0x31, 0x98, 0xa2, 0xe0, 0x37, 0x07, 0x34 };
+  uint8_t expected [] = { 0x39, 0x25, 0x84, 0x1d, 0x02, 0xdc, 0x09, 0xfb,
+                          0xdc, 0x11, 0x85, 0x97, 0x19, 0x6a, 0x0b, 0x32 };
+  uint8_t buffer[16];
+
+  enc_set_key(key);
+  // ECB with the cached key
+  memcpy(buffer, counter, 16);
+  start_timer(TIMER_RES_CLOCK);
+  enc128(buffer);
+  stop_timer();
+  lcd_printf(0, "enc128 %i", get_timer());
+  assert(memcmp(buffer, expected, 16) == 0);
+
+  // CTR on zeros yields the encrypted counter; the key is not re-expanded
+  memset(buffer, 0, 16);
+  enc128_ctr(buffer, 16, counter);
+  assert(memcmp(buffer, expected, 16) == 0);
+  assert(counter[15] == 0x35);
+}
+
+/*
+ * AES-CMAC examples 1-4 from RFC 4493: empty, one complete block, a
+ * partial last block and four complete blocks.
+ */
+static void test_mac64() {
+  test("mac64");
+  uint8_t key[] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+  uint8_t message[] = {
+      0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+      0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+      0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+      0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+      0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+      0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+      0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,
+      0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10 };
+  uint8_t expected0[] = { 0xbb, 0x1d, 0x69, 0x29, 0xe9, 0x59, 0x37, 0x28 };
+  uint8_t expected16[] = { 0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44 };
+  uint8_t expected40[] = { 0xdf, 0xa6, 0x67, 0x47, 0xde, 0x9a, 0xe6, 0x30 };
+  uint8_t expected64[] = { 0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92 };
+  uint8_t mac[HASH_SIZE];
+
+  enc_set_mac_key(key);
+  mac64(mac, message, 0);
+  assert(memcmp(mac, expected0, HASH_SIZE) == 0);
+  mac64(mac, message, 16);
+  assert(memcmp(mac, expected16, HASH_SIZE) == 0);
+  start_timer(TIMER_RES_100us);
+  mac64(mac, message, 40);
+  stop_timer();
+  lcd_printf(0, "mac64 %i", get_timer());
+  assert(memcmp(mac, expected40, HASH_SIZE) == 0);
+  mac64(mac, message, 64);
+  assert(memcmp(mac, expected64, HASH_SIZE) == 0);
+}
+
+/*
+ * enc_set_key MACs with the key encrypted with an all ones block, here
+ * 8af2860142f786f409307c1a3f7eaaac, so that CMAC and CTR never run a
+ * block through the same key.
+ */
+static void test_mac64_derived_key() {
+  test("mac64_derived_key");
+  uint8_t key[] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+  uint8_t message[] = {
+      0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+      0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+      0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+      0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+      0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11 };
+  uint8_t expected16[] = { 0x7d, 0x03, 0x4b, 0xe7, 0xdf, 0xa3, 0x9e, 0x71 };
+  uint8_t expected40[] = { 0xc5, 0xbd, 0x29, 0x3f, 0xb8, 0xc3, 0x69, 0xfc };
+  uint8_t mac[HASH_SIZE];
+
+  enc_set_key(key);
+  mac64(mac, message, 16);
+  assert(memcmp(mac, expected16, HASH_SIZE) == 0);
+  mac64(mac, message, 40);
+  assert(memcmp(mac, expected40, HASH_SIZE) == 0);
+}
+
 void avr_aes_enc_test(void) {
   test_vector_spec();
   test_vector_gladman();
+#ifdef WITH_AES_ASM
+  test_asm_vs_c();
+#endif /* WITH_AES_ASM */
+  test_enc_cached_key();
+  test_mac64();
+  test_mac64_derived_key();
 }
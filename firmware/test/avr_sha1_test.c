@@ -25,6 +25,7 @@
 #include "test.h"
 
 #include "../peripheral/lcd.h"
+#include "../peripheral/timer.h"
 
 static void test_example1() {
   test("example1");
@@ -72,8 +73,46 @@ static void test_station_data() {
   assert(memcmp(hash, resultarray, sizeof(resultarray)) == 0);
 }
 
+#ifdef WITH_SHA1_ASM
+/*
+ * Time of the single block assembly version against the RFC 3174 code,
+ * in 100us units, on every message length it accepts. Both must produce
+ * the same hash.
+ */
+static void test_short_vs_rfc() {
+  test("short_vs_rfc");
+  uint8_t source[SHA1_SHORT_MAX];
+  sha1_hash_t hash_short;
+  sha1_hash_t hash_rfc;
+  uint16_t time_short, time_rfc;
+  uint8_t i;
+
+  for (i = 0; i < SHA1_SHORT_MAX; i++) {
+    source[i] = i * 37 + 5;
+  }
+  for (i = 0; i <= SHA1_SHORT_MAX; i++) {
+    sha1_short(hash_short, source, i);
+    sha1(hash_rfc, source, i);
+    assert(memcmp(hash_short, hash_rfc, sizeof(hash_rfc)) == 0);
+  }
+  start_timer(TIMER_RES_100us);
+  sha1_short(hash_short, source, 32);
+  stop_timer();
+  time_short = get_timer();
+  start_timer(TIMER_RES_100us);
+  sha1(hash_rfc, source, 32);
+  stop_timer();
+  time_rfc = get_timer();
+  lcd_printf(0, "short %u rfc %u", time_short, time_rfc);
+  assert(time_short < time_rfc);
+}
+#endif /* WITH_SHA1_ASM */
+
 void avr_sha1_test(void) {
   test_example1();
   test_example2();
   test_station_data();
+#ifdef WITH_SHA1_ASM
+  test_short_vs_rfc();
+#endif /* WITH_SHA1_ASM */
 }
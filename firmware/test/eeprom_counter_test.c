@@ -0,0 +1,141 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Tests for the wear-leveled station counter and the RAM copy of the
+ * stats. Uses the host EEPROM simulation to cut power while the counter
+ * ring is written.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "../eeprom_data.h"
+#include "../peripheral/eeprom_queue.h"
+#include "../host/host.h"
+
+#include "test.h"
+
+static void __fresh_station(void) {
+  uint8_t station_id[STATION_ID_BYTES] = { 0 };
+  uint8_t station_key[STATION_KEY_BYTES] = { 0 };
+
+  eeprom_host_defer_writes(true);
+  eeprom_write_station_info(station_id, station_key);
+  eeprom_load_counter();
+  eeprom_queue_flush();
+}
+
+static void test_counts_up() {
+  test("counts_up");
+  uint32_t value;
+  uint16_t i;
+
+  __fresh_station();
+  for (i = 1; i <= 3 * COUNTER_SLOTS * COUNTER_LEASE; i++) {
+    eeprom_increment_counter(&value);
+    assert(value == i);
+    assert(eeprom_read_counter() == i);
+    eeprom_queue_flush();
+  }
+  eeprom_host_defer_writes(false);
+}
+
+static void test_does_not_wait() {
+  test("does_not_wait");
+  uint32_t value;
+  uint8_t i;
+
+  __fresh_station();
+  // Unprogrammed writes stay queued: a wait would have flushed them
+  for (i = 0; i < COUNTER_LEASE; i++) {
+    eeprom_increment_counter(&value);
+    if (eeprom_queue_pending()) {
+      break;
+    }
+  }
+  assert(eeprom_queue_pending());
+  eeprom_increment_counter(&value);
+  assert_msg(eeprom_queue_pending(), "waited for EEPROM");
+  eeprom_host_defer_writes(false);
+}
+
+static void test_resumes_after_reset() {
+  test("resumes_after_reset");
+  uint32_t last;
+  uint32_t value;
+
+  __fresh_station();
+  eeprom_increment_counter(&last);
+  eeprom_queue_flush();
+  eeprom_load_counter();
+  eeprom_increment_counter(&value);
+  assert(value > last);
+  assert(value <= last + COUNTER_LEASE + 1);
+  eeprom_host_defer_writes(false);
+}
+
+static void test_power_loss() {
+  test("power_loss");
+  uint32_t last = 0;
+  uint32_t value;
+  uint16_t i;
+  uint8_t n;
+
+  __fresh_station();
+  srand(1);
+  for (i = 0; i < 500; i++) {
+    for (n = rand() % (2 * COUNTER_LEASE); n > 0; n--) {
+      eeprom_increment_counter(&value);
+      assert_msg(value > last, "not monotonic");
+      last = value;
+    }
+    eeprom_host_power_loss(rand() % (sizeof(uint32_t) + 2), rand() & 1);
+    eeprom_load_counter();
+    eeprom_increment_counter(&value);
+    assert_msg(value > last, "went back after power loss");
+    assert_msg(value <= last + 2 * COUNTER_LEASE, "skipped too far");
+    last = value;
+  }
+  eeprom_host_defer_writes(false);
+}
+
+static void test_stats_write_back() {
+  test("stats_write_back");
+
+  __fresh_station();
+  eeprom_host_defer_writes(false);
+  eeprom_clear_stats_changed();
+  eeprom_increment_usart_fail();
+  assert(eeprom_read_number_usart_fail() == 1);
+  assert(eeprom_stats_changed());
+
+  // Lost without write-back
+  eeprom_load_stats();
+  assert(eeprom_read_number_usart_fail() == 0);
+  eeprom_increment_usart_fail();
+  eeprom_write_back_stats();
+  eeprom_load_stats();
+  assert(eeprom_read_number_usart_fail() == 1);
+  assert(eeprom_read_number_porf() == 0);
+}
+
+void eeprom_counter_test(void) {
+  test_counts_up();
+  test_does_not_wait();
+  test_resumes_after_reset();
+  test_power_loss();
+  test_stats_write_back();
+}
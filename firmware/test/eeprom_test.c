@@ -23,6 +23,7 @@
 #include <avr/eeprom.h>
 
 #include "../peripheral/eeprom.h"
+#include "../peripheral/eeprom_queue.h"
 
 #include "test.h"
 
@@ -32,6 +33,7 @@ static void test_simple_increment() {
 
   eeprom_write_dword(memory, 1);
   uint32_t result = increment_eeprom_uint32(memory);
+  eeprom_queue_flush();
   assert(result == 2);
   assert(eeprom_read_dword(memory) == 2);
 }
@@ -42,6 +44,7 @@ static void test_byte_overflow() {
 
   eeprom_write_dword(memory, 0xFF);
   uint32_t result = increment_eeprom_uint32(memory);
+  eeprom_queue_flush();
   assert(result == 0x100);
   assert(eeprom_read_dword(memory) == 0x100);
 }
@@ -52,6 +55,7 @@ static void test_overflow_into_4th_byte() {
 
   eeprom_write_dword(memory, 0x00FFFFFF);
   uint32_t result = increment_eeprom_uint32(memory);
+  eeprom_queue_flush();
   assert(result == 0x01000000);
   assert(eeprom_read_dword(memory) == 0x01000000);
 }
@@ -63,6 +67,7 @@ static void test_rollover_to_zero() {
   eeprom_write_dword(memory, 0xFFFFFFFF);
   eeprom_write_byte((uint8_t *)memory + 4, 0xa5);
   uint32_t result = increment_eeprom_uint32(memory);
+  eeprom_queue_flush();
   assert(result == 0x00000000);
   assert(eeprom_read_dword(memory) == 0x00000000);
   assert(eeprom_read_byte((uint8_t *)memory + 4) == 0xa5);
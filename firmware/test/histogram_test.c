@@ -0,0 +1,97 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Tests for the latency histograms and their serialization.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../histogram.h"
+#include "../proto/base_station.pb.h"
+
+#include "test.h"
+
+// Adds ms and returns the bucket that counted it
+static uint8_t add(uint8_t hist, uint16_t ms) {
+  uint8_t before[HISTOGRAM_BUCKETS];
+  uint8_t i;
+
+  memcpy(before, histogram_counts(hist), sizeof(before));
+  histogram_add(hist, ms);
+  for (i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    if (histogram_counts(hist)[i] != before[i]) {
+      assert_msg(histogram_counts(hist)[i] == (uint8_t)(before[i] + 1),
+                 "count");
+      return i;
+    }
+  }
+  assert_msg(false, "not counted");
+  return 0;
+}
+
+static void test_buckets() {
+  test("histogram_buckets");
+
+  assert(add(HIST_POLL_TO_DETECT, 0) == 0);
+  assert(add(HIST_POLL_TO_DETECT, HISTOGRAM_FIRST_MS - 1) == 0);
+  assert(add(HIST_POLL_TO_DETECT, HISTOGRAM_FIRST_MS) == 1);
+  assert(add(HIST_POLL_TO_DETECT, 2 * HISTOGRAM_FIRST_MS - 1) == 1);
+  assert(add(HIST_POLL_TO_DETECT, 2 * HISTOGRAM_FIRST_MS) == 2);
+  assert(add(HIST_POLL_TO_DETECT, (HISTOGRAM_FIRST_MS << 6) - 1) == 6);
+  assert(add(HIST_POLL_TO_DETECT, HISTOGRAM_FIRST_MS << 6) == 7);
+  assert_msg(add(HIST_POLL_TO_DETECT, 0xffff) == 7, "last bucket open");
+}
+
+static void test_length_and_wrap() {
+  test("histogram_length_and_wrap");
+  uint16_t i;
+
+  assert_msg(histogram_length(HIST_LLCP_SESSION) == 0, "not empty");
+  histogram_add(HIST_LLCP_SESSION, HISTOGRAM_FIRST_MS);
+  assert(histogram_length(HIST_LLCP_SESSION) == 2);
+  for (i = 0; i < 255; i++) {
+    histogram_add(HIST_LLCP_SESSION, HISTOGRAM_FIRST_MS);
+  }
+  assert_msg(histogram_counts(HIST_LLCP_SESSION)[1] == 0, "no wrap");
+  assert(histogram_length(HIST_LLCP_SESSION) == 0);
+}
+
+static void test_serialize() {
+  test("histogram_serialize");
+  static const uint8_t counts[] = { 3, 0, 200 };
+  uint8_t buf[8];
+  uint8_t *bufp = buf;
+
+  assert(serialize_NfcBaseStationInfo__touch_to_push_ms(&bufp, &buf[5],
+                                                         counts, 3));
+  assert(bufp == &buf[5]);
+  // Field 9, wire type 2 (length delimited)
+  assert(buf[0] == 0x4a && buf[1] == 3 && memcmp(&buf[2], counts, 3) == 0);
+
+  bufp = buf;
+  assert_msg(!serialize_NfcBaseStationInfo__llcp_session_ms(&bufp, &buf[4],
+                                                            counts, 3),
+             "overflow");
+  assert_msg(bufp == buf, "partial field");
+}
+
+// all tests
+void histogram_test(void) {
+  test_buckets();
+  test_length_and_wrap();
+  test_serialize();
+}
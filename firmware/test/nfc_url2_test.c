@@ -0,0 +1,161 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Tests for building URLs.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../eeprom_data.h"
+#include "../histogram.h"
+#include "../nfc_url2.h"
+#include "../proto/base_station.pb.h"
+
+#include "test.h"
+
+static uint8_t idm[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+
+static void test_rebuild_url() {
+  test("rebuild_url");
+  char url[URL_LENGTH];
+  char again[URL_LENGTH];
+  uint8_t param[URL_PARAM_BYTES];
+  uint8_t param_length;
+  uint8_t length;
+
+  length = build_url_param(url, sizeof(url), idm, param, &param_length);
+  assert(length > 0);
+  assert(param_length > 0 && param_length <= URL_PARAM_BYTES);
+
+  memset(again, 0, sizeof(again));
+  assert(rebuild_url(again, sizeof(again), param, param_length) == length);
+  assert_msg(strcmp(again, url) == 0, "same URL");
+
+  assert_msg(rebuild_url(again, length, param, param_length) == 0,
+             "no room for NUL");
+  assert(rebuild_url(again, length + 1, param, param_length) == length);
+}
+
+static void test_build_url_tail() {
+  test("build_url_tail");
+  char url[URL_LENGTH];
+  char tail[URL_LENGTH];
+  uint8_t length;
+
+  length = build_url(url, sizeof(url), idm);
+  assert(length > 7);
+  assert(build_url_tail(tail, sizeof(tail), idm, 7) == length - 7);
+  assert_msg(strncmp(tail, &url[7], sizeof(URL) - 8) == 0, "same tail");
+
+  assert(build_url_tail(tail, sizeof(tail), idm, sizeof(URL) - 1) > 0);
+  assert_msg(build_url_tail(tail, sizeof(tail), idm, sizeof(URL)) == 0,
+             "skip past prefix");
+}
+
+// Serializes the station info afresh, as __fill_proto does
+static uint8_t __fresh_station_info(uint8_t buf[], uint8_t voltage,
+                                    uint16_t interval_ms, uint8_t retry) {
+  uint8_t *tmpp = buf;
+  uint8_t *end = &buf[URL_PARAM_BYTES - 1];
+
+  serialize_NfcBaseStationInfo__number_watchdog(&tmpp, end,
+      eeprom_read_number_wdrf());
+  serialize_NfcBaseStationInfo__number_external_reset(&tmpp, end,
+      eeprom_read_number_extrf());
+  serialize_NfcBaseStationInfo__number_power_reset(&tmpp, end,
+      eeprom_read_number_porf());
+  serialize_NfcBaseStationInfo__number_serial_failure(&tmpp, end,
+      eeprom_read_number_usart_fail());
+  serialize_NfcBaseStationInfo__number_brown_out(&tmpp, end,
+      eeprom_read_number_borf());
+  serialize_NfcBaseStationInfo__battery_voltage(&tmpp, end, voltage);
+  serialize_NfcBaseStationInfo__poll_interval_ms(&tmpp, end, interval_ms);
+  serialize_NfcBaseStationInfo__target_mode_retry(&tmpp, end, retry);
+  return tmpp - buf;
+}
+
+static bool __station_info_is(uint8_t voltage, uint16_t interval_ms,
+                              uint8_t retry) {
+  uint8_t cached[URL_PARAM_BYTES];
+  uint8_t fresh[URL_PARAM_BYTES];
+  uint8_t length;
+
+  length = url_station_info(cached, sizeof(cached));
+  return length > 0 &&
+      length == __fresh_station_info(fresh, voltage, interval_ms, retry) &&
+      memcmp(cached, fresh, length) == 0;
+}
+
+static void test_station_info_cache() {
+  test("station_info_cache");
+  uint16_t i;
+
+  set_extra_url_data(200);
+  set_poll_url_data(300, 5);
+  assert(__station_info_is(200, 300, 5));
+  assert_msg(__station_info_is(200, 300, 5), "cached");
+
+  eeprom_increment_usart_fail();
+  assert_msg(__station_info_is(200, 300, 5), "counter");
+  // A whole 8 bit turn of changes is still a change
+  for (i = 0; i < 256; i++) {
+    eeprom_increment_usart_fail();
+  }
+  assert_msg(__station_info_is(200, 300, 5), "256 counts");
+
+  set_extra_url_data(201);
+  assert_msg(__station_info_is(201, 300, 5), "voltage");
+  set_poll_url_data(400, 3);
+  assert_msg(__station_info_is(201, 400, 3), "poll data");
+}
+
+static void test_histogram_room() {
+  test("histogram_room");
+  // Room for arbitrary data in the longest URL
+  uint8_t buf[28 + 1];
+  uint8_t fresh[URL_PARAM_BYTES];
+  uint8_t *histogram;
+  uint8_t length;
+  uint8_t fields;
+
+  // Counters past 128 and a long poll interval take more than 18 bytes
+  set_extra_url_data(201);
+  set_poll_url_data(20000, 3);
+  fields = __fresh_station_info(fresh, 201, 20000, 3);
+  assert(eeprom_read_number_usart_fail() >= 128);
+  assert(fields > sizeof(buf) - 1 - (2 + HISTOGRAM_BUCKETS));
+
+  histogram_add(HIST_LLCP_SESSION, 0xffff);
+  assert(histogram_length(HIST_LLCP_SESSION) == HISTOGRAM_BUCKETS);
+  length = url_arbitrary_data(buf, sizeof(buf) - 1, HIST_LLCP_SESSION);
+  assert(length <= sizeof(buf) - 1);
+  histogram = &buf[length - 2 - HISTOGRAM_BUCKETS];
+  assert_msg(histogram[0] == ((11 << 3) | 2) &&
+             histogram[1] == HISTOGRAM_BUCKETS, "histogram kept");
+  assert(memcmp(&histogram[2], histogram_counts(HIST_LLCP_SESSION),
+                HISTOGRAM_BUCKETS) == 0);
+  // The trailing station info fields made room
+  assert_msg(memcmp(buf, fresh, histogram - buf) == 0, "leading fields");
+}
+
+// all tests
+void nfc_url2_test(void) {
+  test_rebuild_url();
+  test_build_url_tail();
+  test_station_info_cache();
+  test_histogram_room();
+}
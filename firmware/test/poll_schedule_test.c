@@ -0,0 +1,140 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Tests for the adaptive polling interval.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../poll_schedule.h"
+
+#include "test.h"
+
+static void test_busy_after_touch() {
+  test("busy_after_touch");
+  uint8_t i;
+
+  poll_schedule_update(true);
+  assert(poll_schedule_interval_ms() == POLL_INTERVAL_MIN_MS);
+  assert(poll_schedule_target_retries() == TARGET_RETRY_MAX);
+  for (i = 0; i < POLL_BUSY_CYCLES; i++) {
+    poll_schedule_update(false);
+  }
+  assert_msg(poll_schedule_interval_ms() == POLL_INTERVAL_MIN_MS,
+             "grew while busy");
+}
+
+static void test_grows_when_idle() {
+  test("grows_when_idle");
+  uint16_t previous;
+  uint8_t i;
+
+  poll_schedule_update(true);
+  for (i = 0; i < POLL_BUSY_CYCLES; i++) {
+    poll_schedule_update(false);
+  }
+  previous = poll_schedule_interval_ms();
+  poll_schedule_update(false);
+  assert(poll_schedule_interval_ms() > previous);
+  assert(poll_schedule_target_retries() == TARGET_RETRY_MIN);
+  for (i = 0; i < 50; i++) {
+    poll_schedule_update(false);
+  }
+  assert(poll_schedule_interval_ms() == POLL_INTERVAL_MAX_MS);
+}
+
+static void test_touch_resets() {
+  test("touch_resets");
+
+  poll_schedule_update(true);
+  assert(poll_schedule_interval_ms() == POLL_INTERVAL_MIN_MS);
+  assert(poll_schedule_target_retries() == TARGET_RETRY_MAX);
+}
+
+// Returns how often a mode runs in 16 cycles
+static uint8_t __runs(bool (*run)(void)) {
+  uint8_t runs = 0;
+  uint8_t i;
+
+  for (i = 0; i < 16; i++) {
+    runs += run();
+  }
+  return runs;
+}
+
+static void test_no_touches_runs_both() {
+  test("no_touches_runs_both");
+  uint8_t i;
+
+  poll_schedule_load();
+  assert(!poll_schedule_target_first());
+  for (i = 0; i < 16; i++) {
+    assert(poll_schedule_run_initiator());
+    assert(poll_schedule_run_target());
+  }
+}
+
+static void test_target_touches_take_over() {
+  test("target_touches_take_over");
+  uint8_t i;
+
+  for (i = 0; i < 40; i++) {
+    poll_schedule_touch(TOUCH_SNEP);
+  }
+  assert(poll_schedule_target_first());
+  assert(__runs(poll_schedule_run_target) == 16);
+  assert_msg(__runs(poll_schedule_run_initiator) == MODE_SHARE_MIN,
+             "initiator share");
+
+  // A few Felica phones get a larger share, but not the lead
+  for (i = 0; i < 20; i++) {
+    poll_schedule_touch(TOUCH_FELICA_PUSH);
+  }
+  assert(poll_schedule_target_first());
+  assert(__runs(poll_schedule_run_initiator) > MODE_SHARE_MIN);
+}
+
+static void test_weights_saved_as_they_are() {
+  test("weights_saved_as_they_are");
+  uint16_t i;
+
+  // Recent touches win once old ones are halved away
+  for (i = 0; i < 600; i++) {
+    poll_schedule_touch(TOUCH_FELICA_PUSH);
+  }
+  assert(!poll_schedule_target_first());
+  poll_schedule_save();
+
+  // Touches after the save are lost on reset, the halving is not
+  for (i = 0; i < 300; i++) {
+    poll_schedule_touch(TOUCH_SNEP);
+  }
+  assert(poll_schedule_target_first());
+  poll_schedule_load();
+  assert(!poll_schedule_target_first());
+  assert(__runs(poll_schedule_run_initiator) == 16);
+  assert(__runs(poll_schedule_run_target) == MODE_SHARE_MIN);
+}
+
+// all tests
+void poll_schedule_test(void) {
+  test_busy_after_touch();
+  test_grows_when_idle();
+  test_touch_resets();
+  test_no_touches_runs_both();
+  test_target_touches_take_over();
+  test_weights_saved_as_they_are();
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Tests for the RC-S956 frame parser.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rcs956/rcs956_frame.h"
+
+#include "test.h"
+
+static const uint8_t ack[] = { 0x00, 0x00, 0xff, 0x00, 0xff, 0x00 };
+
+// Response to GetFirmwareVersion
+static const uint8_t response[] = {
+  0x00, 0x00, 0xff, 0x06, 0xfa,
+  0xd5, 0x03, 0x33, 0x01, 0x30, 0x07,
+  0xbd, 0x00
+};
+
+static void feed(const uint8_t *data, uint8_t len) {
+  while (len--) {
+    rcs956_frame_feed(*data++);
+  }
+}
+
+static void test_ack() {
+  test("ack");
+  uint8_t buf[8];
+
+  rcs956_frame_reset();
+  rcs956_frame_receive(buf, sizeof(buf));
+  feed(ack, sizeof(ack) - 1);
+  assert_msg(!rcs956_frame_acked(), "acked before postamble");
+  feed(ack + sizeof(ack) - 1, 1);
+  assert_msg(rcs956_frame_acked(), "not acked");
+  assert_msg(!rcs956_frame_done(), "ACK ended the frame");
+  assert_msg(!rcs956_frame_pending(), "ACK left a frame pending");
+  assert(memcmp(buf, ack, sizeof(ack)) == 0);
+}
+
+static void test_response_after_noise() {
+  test("response_after_noise");
+  uint8_t buf[MAX_RECV_SIZE];
+  static const uint8_t noise[] = { 0x12, 0xff, 0x00, 0x34 };
+
+  rcs956_frame_reset();
+  rcs956_frame_receive(buf, sizeof(buf));
+  feed(noise, sizeof(noise));
+  assert_msg(!rcs956_frame_pending(), "noise started a frame");
+  feed(response, sizeof(response));
+  assert(rcs956_frame_done());
+  assert(rcs956_frame_error() == SUCCESS);
+  assert(rcs956_frame_size() == sizeof(response));
+  assert(memcmp(buf, response, sizeof(response)) == 0);
+}
+
+static void test_response_after_ack() {
+  test("response_after_ack");
+  uint8_t buf[MAX_RECV_SIZE];
+
+  // Response arrives right behind the ACK, into the same buffer
+  rcs956_frame_reset();
+  rcs956_frame_receive(buf, sizeof(buf));
+  feed(ack, sizeof(ack));
+  feed(response, 8);
+  assert(rcs956_frame_acked());
+  assert(rcs956_frame_pending());
+  assert(!rcs956_frame_done());
+  feed(response + 8, sizeof(response) - 8);
+  assert(rcs956_frame_done());
+  assert(rcs956_frame_error() == SUCCESS);
+  assert(rcs956_frame_size() == sizeof(response));
+  assert(memcmp(buf, response, sizeof(response)) == 0);
+
+  // Nothing is kept while no buffer is armed
+  rcs956_frame_reset();
+  feed(response, sizeof(response));
+  assert_msg(!rcs956_frame_pending(), "unarmed frame kept");
+  rcs956_frame_receive(buf, sizeof(buf));
+  assert(!rcs956_frame_done());
+  rcs956_frame_reset();
+}
+
+static void test_checksum_errors() {
+  test("checksum_errors");
+  uint8_t buf[MAX_RECV_SIZE];
+  uint8_t bad[sizeof(response)];
+
+  memcpy(bad, response, sizeof(bad));
+  bad[4] ^= 0x01;  // LCS
+  rcs956_frame_reset();
+  rcs956_frame_receive(buf, sizeof(buf));
+  feed(bad, 5);
+  assert_msg(rcs956_frame_done(), "LCS not checked");
+  assert(rcs956_frame_error() == CHECKSUM_ERROR);
+
+  memcpy(bad, response, sizeof(bad));
+  bad[8] ^= 0x01;  // data
+  rcs956_frame_reset();
+  rcs956_frame_receive(buf, sizeof(buf));
+  feed(bad, 12);
+  assert_msg(rcs956_frame_done(), "DCS not checked");
+  assert(rcs956_frame_error() == CHECKSUM_ERROR);
+}
+
+static void test_postamble() {
+  test("postamble");
+  uint8_t buf[MAX_RECV_SIZE];
+  uint8_t bad[sizeof(response)];
+
+  memcpy(bad, response, sizeof(bad));
+  bad[sizeof(bad) - 1] = 0xff;
+  rcs956_frame_reset();
+  rcs956_frame_receive(buf, sizeof(buf));
+  feed(bad, sizeof(bad));
+  assert_msg(rcs956_frame_done(), "postamble not checked");
+  assert(rcs956_frame_error() == UNEXPECTED_REPLY);
+
+  memcpy(bad, ack, sizeof(ack));
+  bad[sizeof(ack) - 1] = 0xff;
+  rcs956_frame_reset();
+  rcs956_frame_receive(buf, sizeof(buf));
+  feed(bad, sizeof(ack));
+  assert_msg(!rcs956_frame_acked(), "ACK postamble not checked");
+  assert(rcs956_frame_done());
+  assert(rcs956_frame_error() == UNEXPECTED_REPLY);
+}
+
+static void test_buffer_exceeded() {
+  test("buffer_exceeded");
+  uint8_t buf[sizeof(response) - 1];
+
+  rcs956_frame_reset();
+  rcs956_frame_receive(buf, sizeof(buf));
+  feed(response, 5);
+  assert_msg(rcs956_frame_done(), "LEN not checked");
+  assert(rcs956_frame_error() == BUFFER_EXCEEDED);
+
+  // Response longer than the buffer behind the ACK
+  rcs956_frame_reset();
+  rcs956_frame_receive(buf, sizeof(buf));
+  feed(ack, sizeof(ack));
+  feed(response, 5);
+  assert(rcs956_frame_done());
+  assert(rcs956_frame_error() == BUFFER_EXCEEDED);
+  rcs956_frame_reset();
+}
+
+// all tests
+void rcs956_frame_test(void) {
+  test_ack();
+  test_response_after_noise();
+  test_response_after_ack();
+  test_checksum_errors();
+  test_postamble();
+  test_buffer_exceeded();
+}
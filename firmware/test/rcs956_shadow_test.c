@@ -0,0 +1,169 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Tests for the RC-S956 shadow state.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../rcs956/rcs956_shadow.h"
+
+#include "test.h"
+
+static const uint8_t retry[] = { 0x02, 0x00, 0x02 };
+
+static void test_reset_until_mode_change() {
+  test("reset_until_mode_change");
+  static const uint8_t rf_config[] = { 0xd4, 0x32 };
+  static const uint8_t list_target[] = { 0xd4, 0x4a };
+  static const uint8_t comm_thru[] = { 0xd4, 0xa0 };
+
+  rcs956_shadow_invalidate();
+  assert(!rcs956_shadow_is_reset());
+  rcs956_shadow_set_reset();
+  rcs956_shadow_command(rf_config);
+  assert_msg(rcs956_shadow_is_reset(), "configuration left mode 0");
+  rcs956_shadow_command(list_target);
+  assert_msg(!rcs956_shadow_is_reset(), "polling kept mode 0");
+
+  assert(rcs956_shadow_has_target());
+
+  // A poll that finds nothing stays in mode 0
+  rcs956_shadow_no_target();
+  assert(!rcs956_shadow_has_target());
+  assert_msg(rcs956_shadow_is_reset(), "empty poll left mode 0");
+  rcs956_shadow_command(rf_config);
+  rcs956_shadow_command(list_target);
+  rcs956_shadow_no_target();
+  assert(rcs956_shadow_is_reset());
+
+  // but only if it was in mode 0 before polling
+  rcs956_shadow_command(comm_thru);
+  rcs956_shadow_command(list_target);
+  rcs956_shadow_no_target();
+  assert_msg(!rcs956_shadow_is_reset(), "empty poll entered mode 0");
+}
+
+static void test_targets_listed() {
+  test("targets_listed");
+  static const uint8_t list_target[] = { 0xd4, 0x4a };
+  static const uint8_t comm_thru[] = { 0xd4, 0xa0 };
+  static const uint8_t in_release[] = { 0xd4, 0x52 };
+  static const uint8_t tg_init_target[] = { 0xd4, 0x8c };
+
+  rcs956_shadow_set_reset();
+  assert(!rcs956_shadow_has_target());
+  rcs956_shadow_command(list_target);
+  rcs956_shadow_command(comm_thru);
+  assert_msg(rcs956_shadow_has_target(), "push released the target");
+  rcs956_shadow_command(in_release);
+  assert(!rcs956_shadow_has_target());
+
+  rcs956_shadow_command(list_target);
+  rcs956_shadow_command(tg_init_target);
+  assert_msg(!rcs956_shadow_has_target(), "target mode kept the target");
+  rcs956_shadow_command(list_target);
+  rcs956_shadow_set_reset();
+  assert(!rcs956_shadow_has_target());
+}
+
+static void test_rf_config() {
+  test("rf_config");
+  static const uint8_t rf_off[] = { 0x00 };
+  static const uint8_t comm_thru[] = { 0xd4, 0xa0 };
+
+  rcs956_shadow_set_reset();
+  assert(!rcs956_shadow_has_rf_config(0x05, retry, sizeof(retry)));
+  rcs956_shadow_set_rf_config(0x05, retry, sizeof(retry));
+  rcs956_shadow_set_rf_config(0x01, rf_off, sizeof(rf_off));
+  assert(rcs956_shadow_has_rf_config(0x05, retry, sizeof(retry)));
+  assert(!rcs956_shadow_has_rf_config(0x05, rf_off, sizeof(rf_off)));
+  assert(rcs956_shadow_has_rf_config(0x01, rf_off, sizeof(rf_off)));
+
+  // Communication turns the RF field on, other settings stay
+  rcs956_shadow_command(comm_thru);
+  assert(!rcs956_shadow_has_rf_config(0x01, rf_off, sizeof(rf_off)));
+  assert(rcs956_shadow_has_rf_config(0x05, retry, sizeof(retry)));
+}
+
+static void test_registers_and_param() {
+  test("registers_and_param");
+
+  rcs956_shadow_set_reset();
+  rcs956_shadow_set_register(0x630d, 0x08);
+  rcs956_shadow_set_param(0x18);
+  assert(rcs956_shadow_has_register(0x630d, 0x08));
+  assert(!rcs956_shadow_has_register(0x630d, 0x00));
+  assert(rcs956_shadow_has_param(0x18));
+
+  rcs956_shadow_set_register(0x630d, 0x00);
+  rcs956_shadow_set_register(0x6301, 0x3b);
+  assert(rcs956_shadow_has_register(0x630d, 0x00));
+  assert(rcs956_shadow_has_register(0x6301, 0x3b));
+  rcs956_shadow_set_register(0x6302, 0x01);
+  assert_msg(!rcs956_shadow_has_register(0x630d, 0x00), "oldest kept");
+  assert(rcs956_shadow_has_register(0x6301, 0x3b));
+}
+
+static void test_forgotten_on_mode_change() {
+  test("forgotten_on_mode_change");
+  static const uint8_t tg_init_target[] = { 0xd4, 0x8c };
+  static const uint8_t in_jump_for_dep[] = { 0xd4, 0x56 };
+  static const uint8_t comm_thru[] = { 0xd4, 0xa0 };
+
+  rcs956_shadow_set_reset();
+  rcs956_shadow_set_register(0x630d, 0x08);
+  rcs956_shadow_set_param(0x18);
+  rcs956_shadow_command(comm_thru);
+  assert_msg(rcs956_shadow_has_register(0x630d, 0x08), "data lost register");
+  assert_msg(rcs956_shadow_has_param(0x18), "data lost param");
+
+  rcs956_shadow_command(tg_init_target);
+  assert(!rcs956_shadow_has_register(0x630d, 0x08));
+  assert(!rcs956_shadow_has_param(0x18));
+
+  rcs956_shadow_set_register(0x630d, 0x08);
+  rcs956_shadow_set_param(0x18);
+  rcs956_shadow_command(in_jump_for_dep);
+  assert(!rcs956_shadow_has_register(0x630d, 0x08));
+  assert(!rcs956_shadow_has_param(0x18));
+}
+
+static void test_forgotten_on_reset_and_timeout() {
+  test("forgotten_on_reset_and_timeout");
+
+  rcs956_shadow_set_rf_config(0x05, retry, sizeof(retry));
+  rcs956_shadow_set_param(0x18);
+  rcs956_shadow_set_reset();
+  assert(!rcs956_shadow_has_rf_config(0x05, retry, sizeof(retry)));
+  assert(!rcs956_shadow_has_param(0x18));
+
+  rcs956_shadow_set_param(0x18);
+  rcs956_shadow_invalidate();
+  assert(!rcs956_shadow_has_param(0x18));
+  assert(!rcs956_shadow_is_reset());
+}
+
+// all tests
+void rcs956_shadow_test(void) {
+  test_reset_until_mode_change();
+  test_targets_listed();
+  test_rf_config();
+  test_registers_and_param();
+  test_forgotten_on_mode_change();
+  test_forgotten_on_reset_and_timeout();
+  rcs956_shadow_invalidate();
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Tests for Smart Poster generation.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../nfc/sp.h"
+
+#include "test.h"
+
+static char *sp_url;
+
+// Adapter method to pass URL making. Set variable sp_url before!
+static uint8_t sp_get_url(uint8_t *buf,
+                          uint8_t __attribute__((unused)) buf_size,
+                          uint8_t skip,
+                          __attribute__((unused)) void* extra) {
+  if (sp_url) {
+    strcpy((char *)buf, sp_url + skip);
+    return strlen(sp_url) - skip;
+  } else {
+    return 0;
+  }
+}
+
+static void test_http_prefix() {
+  test("http_prefix");
+  uint8_t buf[64];
+  uint8_t result;
+
+  sp_url = "http://abc";
+
+  uint8_t expected[] = {
+    0xd1, // MB ME SR TNF=1
+    0x02, // type length
+    0x08, // payload length
+    'S', 'p',
+    0xd1, // MB ME SR TNF=1
+    0x01, // type length
+    0x04, // payload length
+    'U',
+    0x03, // identifier code: "http://"
+    'a', 'b', 'c'
+  };
+  result = smart_poster(buf, sizeof(buf), NULL, sp_url, sp_get_url, NULL);
+
+  assert_msg(result == sizeof(expected), "length");
+  assert_msg(memcmp(buf, expected, sizeof(expected)) == 0, "data");
+}
+
+static void test_longest_prefix_with_label() {
+  test("longest_prefix_with_label");
+  uint8_t buf[64];
+  uint8_t result;
+
+  sp_url = "https://www.x";
+
+  uint8_t expected[] = {
+    0xd1, 0x02, 0x0f, 'S', 'p',
+    0x91, // MB SR TNF=1
+    0x01, 0x05, 'T',
+    0x02, 'e', 'n', 'H', 'i',
+    0x51, // ME SR TNF=1
+    0x01, 0x02, 'U',
+    0x02, // identifier code: "https://www."
+    'x'
+  };
+  result = smart_poster(buf, sizeof(buf), "Hi", sp_url, sp_get_url, NULL);
+
+  assert_msg(result == sizeof(expected), "length");
+  assert_msg(memcmp(buf, expected, sizeof(expected)) == 0, "data");
+}
+
+static void test_no_prefix() {
+  test("no_prefix");
+  uint8_t buf[64];
+  uint8_t result;
+
+  sp_url = "ftp://a";
+
+  uint8_t expected[] = {
+    0xd1, 0x02, 0x0c, 'S', 'p',
+    0xd1, 0x01, 0x08, 'U',
+    0x00, // identifier code: none
+    'f', 't', 'p', ':', '/', '/', 'a'
+  };
+  result = smart_poster(buf, sizeof(buf), NULL, sp_url, sp_get_url, NULL);
+
+  assert_msg(result == sizeof(expected), "length");
+  assert_msg(memcmp(buf, expected, sizeof(expected)) == 0, "data");
+}
+
+static void test_sp_url_error_returns_zero() {
+  test("sp_url_error_returns_zero");
+  uint8_t buf[64];
+
+  sp_url = NULL;  // return error
+
+  assert(smart_poster(buf, sizeof(buf), NULL, sp_url, sp_get_url, NULL) == 0);
+}
+
+// all tests
+void sp_test(void) {
+  test_http_prefix();
+  test_longest_prefix_with_label();
+  test_no_prefix();
+  test_sp_url_error_returns_zero();
+}
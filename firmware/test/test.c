@@ -61,6 +61,7 @@ void assert_msg(bool condition, char* msg)
     } else {
       lcd_puts(1, "FAIL");
     }
+    lcd_update();
     play_melody(melody_fail, sizeof(melody_fail) / sizeof(struct note));
     for (;;);
   }
@@ -82,6 +83,7 @@ void test(char *name)
   num_tests++;
   lcd_puts(0, (strlen(name) > 5) ? name + 5 : name);
   lcd_puts(1, "Testing");
+  lcd_update();
 }
 
 /*
@@ -98,6 +100,7 @@ void test_init(void)
 void success() {
   // LED Green
   lcd_printf(1, "%i tests OK!", num_tests);
+  lcd_update();
   play_melody(melody_success, sizeof(melody_success) / sizeof(struct note));
   for (;;);
 }
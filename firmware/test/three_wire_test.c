@@ -0,0 +1,239 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Timing test for the three-wire driver. Runs the instruction sequences
+ * of twspi_send() and twspi_get() through a cycle model of the AVR and
+ * the Felica Plug and checks clock widths, setup, hold and access time.
+ */
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../peripheral/three_wire_timing.h"
+
+#include "test.h"
+
+// Time is counted in half clock cycles since the input synchronizer
+// delays a pin read by 0.5 to 1.5 cycles.
+#define NS_TO_HALF_CYCLES(ns) \
+  ((uint16_t) (((uint64_t) (ns) * 2 * F_CPU + 999999999) / 1000000000))
+
+#define SYNC_MAX_HALF_CYCLES 3
+
+struct bus {
+  uint16_t now;
+  bool clk;
+  bool data;
+  bool has_rise;
+  uint16_t rise;
+  uint16_t fall;
+  uint16_t data_change;
+  uint16_t data_valid;  // Plug output valid from
+  uint8_t reg;  // %[c] for send, %[d] for get
+  uint8_t plug_out;  // Byte the plug shifts out
+  uint8_t plug_in;  // Bits the plug sampled
+  uint8_t plug_bits;
+};
+
+static struct bus bus;
+
+static void __reset_bus(uint8_t reg, uint8_t plug_out) {
+  memset(&bus, 0, sizeof(bus));
+  bus.clk = true;  // Idle level after the previous byte
+  bus.reg = reg;
+  bus.plug_out = plug_out;
+}
+
+/*
+ * Pin change visible at the end of a port write.
+ */
+static void __write_clk(bool level) {
+  if (level == bus.clk) {
+    return;
+  }
+  bus.clk = level;
+  if (level) {
+    assert_msg(bus.now - bus.fall >=
+               NS_TO_HALF_CYCLES(TWSPI_CLK_LOW_MIN_NS), "clk low");
+    assert_msg(bus.now - bus.data_change >=
+               NS_TO_HALF_CYCLES(TWSPI_SETUP_MIN_NS), "setup");
+    bus.plug_in = (bus.plug_in << 1) | bus.data;
+    bus.rise = bus.now;
+    bus.has_rise = true;
+  } else {
+    if (bus.has_rise) {
+      assert_msg(bus.now - bus.rise >=
+                 NS_TO_HALF_CYCLES(TWSPI_CLK_HIGH_MIN_NS), "clk high");
+    }
+    bus.fall = bus.now;
+    bus.data_valid = bus.now + NS_TO_HALF_CYCLES(TWSPI_ACCESS_MAX_NS);
+    bus.plug_bits++;
+  }
+}
+
+static void __write_data(bool level) {
+  if (level == bus.data) {
+    return;
+  }
+  if (bus.has_rise) {
+    assert_msg(bus.now - bus.rise >= NS_TO_HALF_CYCLES(TWSPI_HOLD_MIN_NS),
+               "hold");
+  }
+  bus.data = level;
+  bus.data_change = bus.now;
+}
+
+/*
+ * Pin read at the start of an instruction.
+ */
+static bool __read_data(void) {
+  assert_msg(bus.now >= bus.data_valid + SYNC_MAX_HALF_CYCLES, "access");
+  return bus.plug_out & (0x80 >> (bus.plug_bits - 1));
+}
+
+static bool __operand_is(const char **p, const char *name) {
+  uint8_t len = strlen(name);
+
+  while (**p == ' ' || **p == ',') {
+    (*p)++;
+  }
+  if (strncmp(*p, name, len) == 0 && !isalnum((*p)[len])) {
+    *p += len;
+    return true;
+  }
+  return false;
+}
+
+static uint8_t __number(const char **p) {
+  char *end;
+  uint8_t value;
+
+  while (**p == ' ' || **p == ',') {
+    (*p)++;
+  }
+  value = strtol(*p, &end, 0);
+  *p = end;
+  return value;
+}
+
+/*
+ * Executes an asm template with AVR cycle counts. Returns the number of
+ * cycles it took.
+ */
+static uint16_t __run(const char *code) {
+  bool skip = false;
+  uint16_t start = bus.now;
+
+  while (*code) {
+    const char *p = code;
+    uint8_t cycles;
+
+    code = strchr(code, '\n');
+    assert_msg(code != NULL, "asm line");
+    code += 2;  // "\n\t"
+
+    if (skip) {
+      bus.now += 2;  // All instructions used here are one word
+      skip = false;
+      continue;
+    }
+    if (__operand_is(&p, "sbi") || __operand_is(&p, "cbi")) {
+      bool level = p[-3] == 's';
+      cycles = 2;
+      bus.now += 2 * cycles;
+      assert(__operand_is(&p, "%[port]"));
+      if (__operand_is(&p, "%[clk]")) {
+        __write_clk(level);
+      } else {
+        assert(__operand_is(&p, "%[data]"));
+        __write_data(level);
+      }
+      continue;
+    }
+    if (__operand_is(&p, "sbrc") || __operand_is(&p, "sbrs")) {
+      bool clear = p[-1] == 'c';
+      assert(__operand_is(&p, "%[c]"));
+      skip = ((bus.reg & (1 << __number(&p))) == 0) == clear;
+    } else if (__operand_is(&p, "sbic")) {
+      assert(__operand_is(&p, "%[pin]"));
+      assert(__operand_is(&p, "%[data]"));
+      skip = !__read_data();
+    } else if (__operand_is(&p, "ori")) {
+      assert(__operand_is(&p, "%[d]"));
+      bus.reg |= __number(&p);
+    } else if (__operand_is(&p, "clr")) {
+      assert(__operand_is(&p, "%[d]"));
+      bus.reg = 0;
+    } else {
+      assert_msg(__operand_is(&p, "nop"), "unknown insn");
+    }
+    bus.now += 2;
+  }
+  return (bus.now - start) / 2;
+}
+
+static void test_send_byte() {
+  test("send_byte");
+  uint16_t c;
+
+  for (c = 0; c < 256; c++) {
+    __reset_bus(c, 0);
+    bus.data = !(c & 0x80);  // Force a data change before the first bit
+    __run(TWSPI_SEND_BYTE);
+    assert(bus.plug_in == c);
+  }
+}
+
+static void test_send_back_to_back() {
+  test("send_back_to_back");
+
+  // Hold time across the byte boundary
+  __reset_bus(0x01, 0);
+  __run(TWSPI_SEND_BYTE);
+  bus.reg = 0xfe;
+  __run(TWSPI_SEND_BYTE);
+  assert(bus.plug_in == 0xfe);
+}
+
+static void test_send_constant_time() {
+  test("send_constant_time");
+
+  __reset_bus(0x00, 0);
+  assert(__run(TWSPI_SEND_BYTE) == 72);
+  __reset_bus(0xff, 0);
+  assert(__run(TWSPI_SEND_BYTE) == 72);
+}
+
+static void test_get_byte() {
+  test("get_byte");
+  uint16_t c;
+
+  for (c = 0; c < 256; c++) {
+    __reset_bus(0x5a, c);
+    __run(TWSPI_GET_BYTE);
+    assert(bus.reg == c);
+    assert(bus.plug_bits == 8);
+  }
+}
+
+void three_wire_test(void) {
+  test_send_byte();
+  test_send_back_to_back();
+  test_send_constant_time();
+  test_get_byte();
+}
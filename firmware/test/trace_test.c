@@ -0,0 +1,100 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Tests for the trace ring and its dump format.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../trace.h"
+
+#include "test.h"
+
+static uint8_t dump[TRACE_DUMP_BYTES];
+
+static void test_encode() {
+  test("trace_encode");
+
+  trace_clear();
+  assert_msg(trace_encode(dump) == TRACE_HEADER_BYTES, "empty dump");
+  assert(dump[0] == 'T' && dump[1] == 'R' && dump[2] == TRACE_FORMAT);
+  assert(dump[3] == 0);
+  assert_msg(dump[4] != 0 || dump[5] != 0, "no tick");
+
+  trace_record(TRACE_POLL_START, 0);
+  trace_record(TRACE_RCS956_CMD, 0x4a);
+  trace_record(TRACE_POLL_END, 1);
+  assert(trace_encode(dump) == TRACE_HEADER_BYTES + 3 * TRACE_RECORD_BYTES);
+  assert(dump[3] == 3);
+  assert(dump[6] == TRACE_POLL_START && dump[7] == 0);
+  assert(dump[10] == TRACE_RCS956_CMD && dump[11] == 0x4a);
+  assert(dump[14] == TRACE_POLL_END && dump[15] == 1);
+  // Recorded back to back, well within a tick or two
+  assert_msg((uint16_t)((dump[16] | dump[17] << 8)
+                        - (dump[8] | dump[9] << 8)) < 100, "time");
+}
+
+static void test_ring_wraps() {
+  test("trace_ring_wraps");
+  uint8_t i;
+
+  trace_clear();
+  for (i = 0; i < TRACE_ENTRIES + 2; i++) {
+    trace_record(TRACE_EEPROM_WRITE, i);
+  }
+  assert(trace_encode(dump) == TRACE_DUMP_BYTES);
+  assert(dump[3] == TRACE_ENTRIES);
+  assert_msg(dump[TRACE_HEADER_BYTES + 1] == 2, "oldest not first");
+  assert_msg(dump[TRACE_DUMP_BYTES - TRACE_RECORD_BYTES + 1]
+             == TRACE_ENTRIES + 1, "newest not last");
+}
+
+static void test_ms_since() {
+  test("trace_ms_since");
+
+  trace_clear();
+  assert(trace_ms_since(TRACE_POLL_START) == 0xffff);
+  trace_record(TRACE_POLL_START, 0);
+  trace_record(TRACE_POLL_END, 0);
+  assert(trace_ms_since(TRACE_POLL_START) < 10);
+  assert(trace_ms_since(TRACE_TOUCH) == 0xffff);
+  trace_clear();
+}
+
+static void test_hold() {
+  test("trace_hold");
+
+  trace_clear();
+  trace_record(TRACE_POLL_START, 0);
+  trace_hold();
+  assert(trace_held());
+  trace_record(TRACE_POLL_END, 0);
+  assert_msg(trace_encode(dump) == TRACE_HEADER_BYTES + TRACE_RECORD_BYTES,
+             "recorded while held");
+  trace_save();
+  assert(!trace_held());
+  trace_record(TRACE_POLL_END, 0);
+  assert(trace_encode(dump) == TRACE_HEADER_BYTES + 2 * TRACE_RECORD_BYTES);
+  trace_clear();
+}
+
+// all tests
+void trace_test(void) {
+  test_encode();
+  test_ring_wraps();
+  test_hold();
+  test_ms_since();
+}
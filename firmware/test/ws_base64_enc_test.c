@@ -87,10 +87,58 @@ static void test_simple_case() {
   assert(out[5] == MARKER);
 }
 
+static void test_partial_groups() {
+  test("test_partial_groups");
+  char out[5];
+  uint8_t input[] = { 0x12, 0x34 };
+
+  memset(out, MARKER, sizeof(out));
+  assert(websafe_base64_encode(out, 4, input, 2));
+  assert(strcmp(out, "EjQ") == 0);
+  assert(out[4] == MARKER);
+
+  memset(out, MARKER, sizeof(out));
+  assert(websafe_base64_encode(out, 3, input, 1));
+  assert(strcmp(out, "Eg") == 0);
+  assert(out[3] == MARKER);
+
+  assert(!websafe_base64_encode(out, 3, input, 2));
+}
+
+static void test_all_characters() {
+  test("test_all_characters");
+  char out[65];
+  uint8_t input[] = {
+      0x00, 0x10, 0x83, 0x10, 0x51, 0x87, 0x20, 0x92, 0x8b, 0x30, 0xd3, 0x8f,
+      0x41, 0x14, 0x93, 0x51, 0x55, 0x97, 0x61, 0x96, 0x9b, 0x71, 0xd7, 0x9f,
+      0x82, 0x18, 0xa3, 0x92, 0x59, 0xa7, 0xa2, 0x9a, 0xab, 0xb2, 0xdb, 0xaf,
+      0xc3, 0x1c, 0xb3, 0xd3, 0x5d, 0xb7, 0xe3, 0x9e, 0xbb, 0xf3, 0xdf, 0xbf
+  };
+
+  assert(websafe_base64_encode(out, sizeof(out), input, sizeof(input)));
+  assert(strcmp(out, "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+                     "0123456789-_") == 0);
+}
+
+static void test_in_place() {
+  test("test_in_place");
+  char out[9];
+  uint8_t input[] = { 0x12, 0x34, 0x56, 0x78, 0x9a };
+
+  // 5 bytes start (5 + 2) / 3 = 2 bytes into the output
+  memcpy(&out[2], input, sizeof(input));
+  assert(websafe_base64_encode(out, sizeof(out), (uint8_t *)&out[2],
+                               sizeof(input)));
+  assert(strcmp(out, "EjRWeJo") == 0);
+}
+
 void ws_base_64_enc_test(void) {
   test_no_data_makes_empty_string();
   test_buffer_overflow_returns_false();
   test_buffer_cannot_hold_nul_returns_false();
   test_empty_buffer_writes_nothing();
   test_simple_case();
+  test_partial_groups();
+  test_all_characters();
+  test_in_place();
 }
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Trace ring of the touch path, see trace.h.
+ */
+
+#include <stdbool.h>
+
+#include "eeprom_data.h"
+#include "peripheral/timer.h"
+#include "peripheral/usart.h"
+
+#include "trace.h"
+
+#if TRACE_DUMP_BYTES > TRACE_PAGE_BYTES
+#error "trace dump does not fit the EEPROM trace page"
+#endif
+
+// Clock tick in 10ns units, as stored in the dump header
+#define TRACE_TICK_10NS \
+  ((TRACE_CLOCK_PRESCALER * 100000000ULL + F_CPU / 2) / F_CPU)
+
+struct trace_entry {
+  uint8_t event;
+  uint8_t arg;
+  uint16_t time;
+};
+
+static struct trace_entry ring[TRACE_ENTRIES];
+static uint8_t ring_next = 0;  // where the next record goes
+static bool ring_full = false;
+static bool ring_held = false;
+
+void trace_record(uint8_t event, uint8_t arg)
+{
+  struct trace_entry *entry = &ring[ring_next];
+
+  if (ring_held) {
+    return;
+  }
+  entry->event = event;
+  entry->arg = arg;
+  entry->time = trace_clock();
+  if (++ring_next == TRACE_ENTRIES) {
+    ring_next = 0;
+    ring_full = true;
+  }
+}
+
+void trace_clear(void)
+{
+  ring_next = 0;
+  ring_full = false;
+  ring_held = false;
+}
+
+void trace_hold(void)
+{
+  ring_held = true;
+}
+
+bool trace_held(void)
+{
+  return ring_held;
+}
+
+static uint8_t __count(void)
+{
+  return ring_full ? TRACE_ENTRIES : ring_next;
+}
+
+/*
+ * Returns byte i of the dump, i < TRACE_HEADER_BYTES + records.
+ */
+static uint8_t __dump_byte(uint8_t i)
+{
+  const struct trace_entry *entry;
+  uint8_t index;
+
+  switch (i) {
+    case 0: return 'T';
+    case 1: return 'R';
+    case 2: return TRACE_FORMAT;
+    case 3: return __count();
+    case 4: return TRACE_TICK_10NS & 0xff;
+    case 5: return TRACE_TICK_10NS >> 8;
+  }
+  i -= TRACE_HEADER_BYTES;
+  // The oldest record is the next to be overwritten once the ring is full
+  index = i / TRACE_RECORD_BYTES + (ring_full ? ring_next : 0);
+  if (index >= TRACE_ENTRIES) {
+    index -= TRACE_ENTRIES;
+  }
+  entry = &ring[index];
+  switch (i % TRACE_RECORD_BYTES) {
+    case 0: return entry->event;
+    case 1: return entry->arg;
+    case 2: return entry->time & 0xff;
+    default: return entry->time >> 8;
+  }
+}
+
+static uint8_t __dump_length(void)
+{
+  return TRACE_HEADER_BYTES + __count() * TRACE_RECORD_BYTES;
+}
+
+uint8_t trace_encode(uint8_t *buf)
+{
+  uint8_t i;
+  uint8_t len = __dump_length();
+
+  for (i = 0; i < len; i++) {
+    buf[i] = __dump_byte(i);
+  }
+  return len;
+}
+
+uint16_t trace_ms_since(uint8_t event)
+{
+  uint8_t index = ring_next;
+  uint8_t n;
+
+  for (n = __count(); n > 0; n--) {
+    index = (index == 0 ? TRACE_ENTRIES : index) - 1;
+    if (ring[index].event == event) {
+      uint32_t cycles = (uint16_t)(trace_clock() - ring[index].time);
+      return cycles * TRACE_CLOCK_PRESCALER / (F_CPU / 1000);
+    }
+  }
+  return 0xffff;
+}
+
+void trace_dump(void)
+{
+  uint8_t i;
+  uint8_t len = __dump_length();
+
+  for (i = 0; i < len; i++) {
+    usart_send(__dump_byte(i));
+  }
+  usart_flush();
+}
+
+/*
+ * Writes to the trace page are not traced themselves, so the ring stays
+ * as it was while it is queued.
+ */
+void trace_save(void)
+{
+  uint8_t i;
+  uint8_t len = __dump_length();
+
+  for (i = 0; i < len; i++) {
+    eeprom_write_trace(i, __dump_byte(i));
+  }
+  ring_held = false;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2012 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Compact binary trace of the touch path. Records of (event, Timer 1
+ * time, argument) go into a fixed RAM ring, overwriting the oldest. The
+ * ring is dumped over the USART or saved into an EEPROM page, and
+ * host/trace_decode prints it.
+ *
+ * Call sites use trace(), which compiles away unless WITH_TRACE is set.
+ *
+ * Timer 1 stops in power-save sleep. The Felica Plug sleeps that way
+ * between reader commands, so its records leave the sleep out and the
+ * time between them reads short.
+ *
+ * Dump format, multi-byte values little endian:
+ *   'T' 'R' TRACE_FORMAT count tick(2)   tick: clock tick in 10ns units
+ *   count records: event arg time(2)     oldest first
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Records kept in RAM
+#ifndef TRACE_ENTRIES
+#define TRACE_ENTRIES 30
+#endif
+
+#define TRACE_FORMAT 1
+#define TRACE_HEADER_BYTES 6
+#define TRACE_RECORD_BYTES 4
+#define TRACE_DUMP_BYTES \
+  (TRACE_HEADER_BYTES + TRACE_ENTRIES * TRACE_RECORD_BYTES)
+
+// Touches taking longer than this from poll or target start keep their
+// trace in EEPROM
+#ifndef TRACE_SLOW_TOUCH_MS
+#define TRACE_SLOW_TOUCH_MS 1000
+#endif
+
+enum trace_event {
+  TRACE_NONE,
+  TRACE_POLL_START,
+  TRACE_POLL_END,       // arg: 1 if a phone was found
+  TRACE_TARGET_START,
+  TRACE_TARGET_END,     // arg: enum target_res
+  TRACE_URL_BUILD,      // arg: 1 if rebuilt from a kept v parameter
+  TRACE_URL_BUILT,      // arg: URL length, 0 on error
+  TRACE_RCS956_CMD,     // arg: command code
+  TRACE_RCS956_ACK,     // arg: protocol_errno
+  TRACE_RCS956_RESP,    // arg: protocol_errno
+  TRACE_RCS956_CANCEL,
+  TRACE_LLCP_STATE,     // arg: new llcp state
+  TRACE_EEPROM_WRITE,   // arg: bytes queued
+  TRACE_TOUCH,          // arg: enum touch_kind
+  NUM_TRACE_EVENTS
+};
+
+// Appends a record stamped with trace_clock().
+void trace_record(uint8_t event, uint8_t arg);
+
+// Drops all records.
+void trace_clear(void);
+
+// Writes the dump into buf (TRACE_DUMP_BYTES). Returns its length.
+uint8_t trace_encode(uint8_t *buf);
+
+// Returns ms since the newest record of event, 0xffff if there is none.
+// Gaps over one trace clock wrap (about 4.7s) are not told apart.
+uint16_t trace_ms_since(uint8_t event);
+
+// Sends the dump over the USART, which must be initialized.
+void trace_dump(void);
+
+// Stops recording, keeping the ring as it is for trace_save().
+void trace_hold(void);
+
+// True while the ring is held.
+bool trace_held(void);
+
+// Queues the dump for writing into the EEPROM trace page and records
+// again. Waits for the EEPROM at ~3.3ms per byte, so call it when idle.
+void trace_save(void);
+
+#ifdef WITH_TRACE
+#define trace(event, arg) trace_record((event), (arg))
+#else
+#define trace(event, arg) ((void)0)
+#endif
+
+#endif /* !__TRACE_H__ */